@@ -0,0 +1,606 @@
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <functional>
+#include <list>
+#include <memory>
+#include <memory_resource>
+#include <string>
+#include <thread>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+#include <benchmark/benchmark.h>
+
+#include "cdif.h"
+
+namespace {
+    class IService
+    {
+        public:
+            virtual ~IService() = default;
+            virtual int value() const = 0;
+    };
+
+    class Service : public IService
+    {
+        private:
+            int m_value;
+
+        public:
+            Service(int value) : m_value(value) {}
+
+            int value() const override { return m_value; }
+    };
+
+    class OtherService : public IService
+    {
+        private:
+            int m_value;
+
+        public:
+            OtherService(int value) : m_value(value + 1) {}
+
+            int value() const override { return m_value; }
+    };
+
+    template <size_t Depth>
+    struct Chain
+    {
+        std::shared_ptr<Chain<Depth - 1>> m_next;
+
+        Chain(std::shared_ptr<Chain<Depth - 1>> next) : m_next(std::move(next)) {}
+    };
+
+    template <>
+    struct Chain<0>
+    {
+        Chain() {}
+    };
+
+    template <size_t Index>
+    struct Leaf
+    {
+        Leaf() {}
+    };
+
+    template <typename Indices>
+    struct WideImpl;
+
+    template <size_t ... Indices>
+    struct WideImpl<std::index_sequence<Indices...>>
+    {
+        std::tuple<std::shared_ptr<Leaf<Indices>>...> m_leaves;
+
+        WideImpl(std::shared_ptr<Leaf<Indices>> ... leaves) : m_leaves(std::move(leaves)...) {}
+    };
+
+    template <size_t Width>
+    using Wide = WideImpl<std::make_index_sequence<Width>>;
+
+    template <size_t Depth>
+    void bindChain(cdif::Container& ctx)
+    {
+        if constexpr (Depth == 0) {
+            ctx.bind<Chain<0>>().build();
+        } else {
+            bindChain<Depth - 1>(ctx);
+            ctx.bind<Chain<Depth>, std::shared_ptr<Chain<Depth - 1>>>().build();
+        }
+    }
+
+    template <size_t Depth>
+    std::shared_ptr<Chain<Depth>> buildChainByHand()
+    {
+        if constexpr (Depth == 0)
+            return std::make_shared<Chain<0>>();
+        else
+            return std::make_shared<Chain<Depth>>(buildChainByHand<Depth - 1>());
+    }
+
+    template <size_t ... Indices>
+    void bindWide(cdif::Container& ctx, std::index_sequence<Indices...>)
+    {
+        ( ctx.bind<Leaf<Indices>>().build(), ... );
+        ctx.bind<Wide<sizeof...(Indices)>, std::shared_ptr<Leaf<Indices>>...>().build();
+    }
+
+    template <size_t ... Indices>
+    void bindScopedWide(cdif::Container& ctx, std::index_sequence<Indices...>)
+    {
+        ( ctx.bind<Leaf<Indices>>().template in<cdif::Scope::PerScope>().build(), ... );
+        ctx.bind<Wide<sizeof...(Indices)>, std::shared_ptr<Leaf<Indices>>...>()
+            .template in<cdif::Scope::PerScope>()
+            .build();
+    }
+
+    template <size_t ... Indices>
+    std::shared_ptr<Wide<sizeof...(Indices)>> buildWideByHand(std::index_sequence<Indices...>)
+    {
+        return std::make_shared<Wide<sizeof...(Indices)>>(std::make_shared<Leaf<Indices>>()...);
+    }
+
+    void bindValue(cdif::Container& ctx)
+    {
+        ctx.bind<int>([] () { return 42; }).build();
+    }
+
+    int staticValue()
+    {
+        return 42;
+    }
+
+    template <cdif::Scope TScope>
+    using StaticTypeContainer = cdif::StaticContainer<
+        cdif::BindFactory<&staticValue>,
+        typename cdif::Bind<Service, int>::template as<IService>::template in<TScope>>;
+
+    // A singleton whose construction waits on I/O.
+    template <size_t Id>
+    struct SlowLeaf
+    {
+        SlowLeaf() { std::this_thread::sleep_for(std::chrono::milliseconds(1)); }
+    };
+
+    template <size_t ... Indices>
+    struct SlowFanOut
+    {
+        SlowFanOut(SlowLeaf<Indices>& ...) {}
+    };
+
+    template <size_t ... Indices>
+    SlowFanOut<Indices...> fanOutOf(std::index_sequence<Indices...>);
+
+    template <size_t ... Indices>
+    cdif::Container createSlowListContainer(bool parallel, std::index_sequence<Indices...>)
+    {
+        auto ctx = cdif::Container();
+        ( ctx.bind<SlowLeaf<Indices>>().build(), ... );
+        auto list = ctx.bindList<std::shared_ptr<void>, std::shared_ptr<SlowLeaf<Indices>>...>();
+        if (parallel)
+            list.inParallel();
+        list.build();
+        return ctx;
+    }
+
+    template <size_t ... Indices>
+    cdif::Container createSlowFanOutContainer(std::index_sequence<Indices...>)
+    {
+        auto ctx = cdif::Container();
+        ( ctx.bind<SlowLeaf<Indices>>().template in<cdif::Scope::Singleton>().build(), ... );
+        ctx.bind<SlowFanOut<Indices...>, SlowLeaf<Indices>&...>().build();
+        return ctx;
+    }
+
+    template <cdif::Scope TScope>
+    cdif::Container createTypeContainer()
+    {
+        auto ctx = cdif::Container();
+        bindValue(ctx);
+        ctx.bind<Service, int>().in<TScope>().build();
+        return ctx;
+    }
+
+    template <cdif::Scope TScope>
+    cdif::Container& sharedTypeContainer()
+    {
+        static auto ctx = createTypeContainer<TScope>();
+        return ctx;
+    }
+}
+
+// Startup, binding a named service of each kind many times over. Each bind
+// adds registrations_per_bind registrations to the container.
+
+template <typename TBind>
+static void runBindBenchmark(benchmark::State& state, TBind bind)
+{
+    auto count = static_cast<size_t>(state.range(0));
+    auto names = std::vector<std::string>();
+    for (size_t i = 0; i < count; i++)
+        names.push_back("service" + std::to_string(i));
+
+    size_t registrations = 0;
+    for (auto _ : state) {
+        auto ctx = std::make_unique<cdif::Container>();
+        for (auto& name : names)
+            bind(*ctx, name);
+
+        state.PauseTiming();
+        registrations = ctx->registrationCount();
+        ctx.reset();
+        state.ResumeTiming();
+    }
+
+    state.SetItemsProcessed(state.iterations() * static_cast<int64_t>(count));
+    state.counters["registrations_per_bind"] = static_cast<double>(registrations) / static_cast<double>(count);
+}
+
+template <cdif::Scope TScope>
+static void BM_Bind_Type(benchmark::State& state)
+{
+    runBindBenchmark(state, [] (cdif::Container& ctx, const std::string& name)
+        {
+            ctx.bind<Service, int>().template in<TScope>().named(name).build();
+        });
+}
+
+template <cdif::Scope TScope>
+static void BM_Bind_Interface(benchmark::State& state)
+{
+    runBindBenchmark(state, [] (cdif::Container& ctx, const std::string& name)
+        {
+            ctx.bind<Service, int>().as<IService>().template in<TScope>().named(name).build();
+        });
+}
+
+template <cdif::Scope TScope>
+static void BM_Bind_List(benchmark::State& state)
+{
+    runBindBenchmark(state, [] (cdif::Container& ctx, const std::string& name)
+        {
+            ctx.bindList<std::shared_ptr<IService>, std::shared_ptr<Service>, std::shared_ptr<OtherService>>()
+                .template in<TScope>()
+                .named(name)
+                .build();
+        });
+}
+
+// Hand-wired baselines, the cost of building the same objects without cdif.
+
+static void BM_HandWired_Type(benchmark::State& state)
+{
+    for (auto _ : state)
+        benchmark::DoNotOptimize(std::make_shared<Service>(42));
+}
+
+static void BM_HandWired_Interface(benchmark::State& state)
+{
+    for (auto _ : state)
+        benchmark::DoNotOptimize(std::shared_ptr<IService>(std::make_shared<Service>(42)));
+}
+
+static void BM_HandWired_List(benchmark::State& state)
+{
+    for (auto _ : state) {
+        auto list = std::vector<std::shared_ptr<IService>>();
+        list.push_back(std::make_shared<Service>(42));
+        list.push_back(std::make_shared<OtherService>(42));
+        benchmark::DoNotOptimize(list);
+    }
+}
+
+template <size_t Depth>
+static void BM_HandWired_Depth(benchmark::State& state)
+{
+    for (auto _ : state)
+        benchmark::DoNotOptimize(buildChainByHand<Depth>());
+}
+
+template <size_t Width>
+static void BM_HandWired_Width(benchmark::State& state)
+{
+    for (auto _ : state)
+        benchmark::DoNotOptimize(buildWideByHand(std::make_index_sequence<Width>{}));
+}
+
+// Registration kinds in each scope.
+
+template <cdif::Scope TScope>
+static void BM_Resolve_Type(benchmark::State& state)
+{
+    cdif::Container& ctx = sharedTypeContainer<TScope>();
+
+    for (auto _ : state)
+        benchmark::DoNotOptimize(ctx.resolve<std::shared_ptr<Service>>());
+
+    state.SetItemsProcessed(static_cast<int64_t>(state.iterations()));
+}
+
+template <cdif::Scope TScope>
+static void BM_Resolve_Interface(benchmark::State& state)
+{
+    auto ctx = cdif::Container();
+    bindValue(ctx);
+    ctx.bind<Service, int>().as<IService>().in<TScope>().build();
+
+    for (auto _ : state)
+        benchmark::DoNotOptimize(ctx.resolve<std::shared_ptr<IService>>());
+}
+
+template <cdif::Scope TScope>
+static void BM_Resolve_Factory(benchmark::State& state)
+{
+    auto ctx = cdif::Container();
+    bindValue(ctx);
+    ctx.bind<Service, int>([] (int value) { return Service(value); }).template in<TScope>().build();
+
+    if constexpr (TScope == cdif::Scope::PerDependency) {
+        for (auto _ : state)
+            benchmark::DoNotOptimize(ctx.resolve<Service>());
+    } else {
+        for (auto _ : state)
+            benchmark::DoNotOptimize(ctx.resolve<std::function<Service* (int)>>()(42));
+    }
+}
+
+template <cdif::Scope TScope>
+static void BM_Resolve_List(benchmark::State& state)
+{
+    using List = std::vector<std::shared_ptr<IService>>;
+
+    auto ctx = cdif::Container();
+    bindValue(ctx);
+    ctx.bind<Service, int>().build();
+    ctx.bind<OtherService, int>().build();
+    ctx.bindList<std::shared_ptr<IService>, std::shared_ptr<Service>, std::shared_ptr<OtherService>>()
+        .in<TScope>()
+        .build();
+
+    if constexpr (TScope == cdif::Scope::PerDependency) {
+        for (auto _ : state)
+            benchmark::DoNotOptimize(ctx.resolve<List>());
+    } else {
+        for (auto _ : state)
+            benchmark::DoNotOptimize(&ctx.resolve<List&>());
+    }
+}
+
+// The same PerDependency list resolved as each list type.
+
+template <typename TList>
+static void BM_Resolve_ListAs(benchmark::State& state)
+{
+    auto ctx = cdif::Container();
+    bindValue(ctx);
+    ctx.bind<Service, int>().build();
+    ctx.bind<OtherService, int>().build();
+    ctx.bindList<std::shared_ptr<IService>, std::shared_ptr<Service>, std::shared_ptr<OtherService>>().build();
+
+    for (auto _ : state)
+        benchmark::DoNotOptimize(ctx.resolve<TList>());
+}
+
+// Dispatch to the first element of an eight element list, building the
+// whole vector or only what a LazyList reaches.
+
+static void BM_Resolve_FirstOfList(benchmark::State& state)
+{
+    using Shared = std::shared_ptr<Service>;
+
+    auto ctx = cdif::Container();
+    bindValue(ctx);
+    ctx.bind<Service, int>().build();
+    ctx.bindList<std::shared_ptr<IService>, Shared, Shared, Shared, Shared, Shared, Shared, Shared, Shared>().build();
+
+    if (state.range(0) == 0) {
+        for (auto _ : state)
+            benchmark::DoNotOptimize(ctx.resolve<std::vector<std::shared_ptr<IService>>>().front()->value());
+    } else {
+        for (auto _ : state)
+            benchmark::DoNotOptimize(ctx.resolve<cdif::LazyList<std::shared_ptr<IService>>>().begin()->get()->value());
+    }
+}
+
+// A PerDependency list of Width elements that each take 1 ms to build,
+// resolved one after the other or in parallel.
+
+template <size_t Width>
+static void BM_Resolve_SlowList(benchmark::State& state)
+{
+    cdif::Container ctx = createSlowListContainer(state.range(0) != 0, std::make_index_sequence<Width>{});
+
+    for (auto _ : state)
+        benchmark::DoNotOptimize(ctx.resolve<std::vector<std::shared_ptr<void>>>());
+}
+
+// PerDependency smart pointers from the global heap or a pooled resource.
+
+static void BM_Resolve_PooledSharedPtr(benchmark::State& state)
+{
+    auto pool = std::pmr::unsynchronized_pool_resource();
+    auto ctx = cdif::Container();
+    bindValue(ctx);
+    ctx.bind<Service, int>().withMemoryResource(&pool).build();
+
+    for (auto _ : state)
+        benchmark::DoNotOptimize(ctx.resolve<std::shared_ptr<Service>>());
+}
+
+static void BM_Resolve_PooledUniquePtr(benchmark::State& state)
+{
+    auto pool = std::pmr::unsynchronized_pool_resource();
+    auto ctx = cdif::Container();
+    bindValue(ctx);
+    ctx.bind<Service, int>().withMemoryResource(&pool).build();
+
+    for (auto _ : state)
+        benchmark::DoNotOptimize(ctx.resolve<cdif::pmr_unique_ptr<Service>>());
+}
+
+// The same registrations bound at compile time.
+
+static void BM_Static_Type(benchmark::State& state)
+{
+    auto ctx = StaticTypeContainer<cdif::Scope::PerDependency>();
+
+    for (auto _ : state)
+        benchmark::DoNotOptimize(ctx.resolve<std::shared_ptr<Service>>());
+}
+
+static void BM_Static_Interface(benchmark::State& state)
+{
+    auto ctx = StaticTypeContainer<cdif::Scope::PerDependency>();
+
+    for (auto _ : state)
+        benchmark::DoNotOptimize(ctx.resolve<std::shared_ptr<IService>>());
+}
+
+static void BM_Static_Singleton(benchmark::State& state)
+{
+    auto ctx = StaticTypeContainer<cdif::Scope::Singleton>();
+
+    for (auto _ : state)
+        benchmark::DoNotOptimize(&ctx.resolve<IService&>());
+}
+
+// Resolving by name in a loop against a handle bound to the registration.
+
+static void BM_Resolve_Named(benchmark::State& state)
+{
+    auto ctx = cdif::Container();
+    bindValue(ctx);
+    ctx.bind<Service, int>().named("service").build();
+
+    for (auto _ : state)
+        benchmark::DoNotOptimize(ctx.resolve<std::shared_ptr<Service>>("service"));
+}
+
+// A thread switching between two PerThread registrations of one type.
+static void BM_Resolve_AlternatingPerThread(benchmark::State& state)
+{
+    auto ctx = cdif::Container();
+    bindValue(ctx);
+    ctx.bind<Service, int>().in<cdif::Scope::PerThread>().build();
+    ctx.bind<Service, int>().named("other").in<cdif::Scope::PerThread>().build();
+
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(ctx.resolve<Service*>());
+        benchmark::DoNotOptimize(ctx.resolve<Service*>("other"));
+    }
+}
+
+static void BM_Provider_Named(benchmark::State& state)
+{
+    auto ctx = cdif::Container();
+    bindValue(ctx);
+    ctx.bind<Service, int>().named("service").build();
+    auto provider = ctx.provider<std::shared_ptr<Service>>("service");
+
+    for (auto _ : state)
+        benchmark::DoNotOptimize(provider());
+}
+
+// Graph shape.
+
+template <size_t Depth>
+static void BM_Resolve_Depth(benchmark::State& state)
+{
+    auto ctx = cdif::Container();
+    bindChain<Depth>(ctx);
+
+    for (auto _ : state)
+        benchmark::DoNotOptimize(ctx.resolve<std::shared_ptr<Chain<Depth>>>());
+}
+
+template <size_t Width>
+static void BM_Resolve_Width(benchmark::State& state)
+{
+    auto ctx = cdif::Container();
+    bindWide(ctx, std::make_index_sequence<Width>{});
+
+    for (auto _ : state)
+        benchmark::DoNotOptimize(ctx.resolve<std::shared_ptr<Wide<Width>>>());
+}
+
+// Cold start, the first resolve of a service over Width singletons that
+// each take 1 ms to build, resolved in place or with resolveAsync().
+
+template <size_t Width>
+static void BM_ColdResolve_FanOut(benchmark::State& state)
+{
+    using Indices = std::make_index_sequence<Width>;
+    using TFanOut = decltype(fanOutOf(Indices{}));
+
+    for (auto _ : state) {
+        state.PauseTiming();
+        cdif::Container ctx = createSlowFanOutContainer(Indices{});
+        state.ResumeTiming();
+
+        if (state.range(0) == 0)
+            benchmark::DoNotOptimize(ctx.resolve<TFanOut>());
+        else
+            benchmark::DoNotOptimize(ctx.resolveAsync<TFanOut>().get());
+    }
+}
+
+// A graph resolved once per request, either a fresh heap allocation per
+// object or shared within a scope and allocated from its arena.
+
+template <size_t Width>
+static void BM_Request_PerDependency(benchmark::State& state)
+{
+    auto ctx = cdif::Container();
+    bindWide(ctx, std::make_index_sequence<Width>{});
+
+    for (auto _ : state) {
+        auto scope = ctx.beginScope();
+        benchmark::DoNotOptimize(scope.resolve<std::shared_ptr<Wide<Width>>>());
+    }
+}
+
+template <size_t Width>
+static void BM_Request_PerScope(benchmark::State& state)
+{
+    auto ctx = cdif::Container();
+    bindScopedWide(ctx, std::make_index_sequence<Width>{});
+
+    for (auto _ : state) {
+        auto scope = ctx.beginScope();
+        benchmark::DoNotOptimize(&scope.resolve<Wide<Width>&>());
+    }
+}
+
+BENCHMARK_TEMPLATE(BM_Bind_Type, cdif::Scope::PerDependency)->Arg(1000);
+BENCHMARK_TEMPLATE(BM_Bind_Type, cdif::Scope::Singleton)->Arg(1000);
+BENCHMARK_TEMPLATE(BM_Bind_Interface, cdif::Scope::PerDependency)->Arg(1000);
+BENCHMARK_TEMPLATE(BM_Bind_Interface, cdif::Scope::Singleton)->Arg(1000);
+BENCHMARK_TEMPLATE(BM_Bind_List, cdif::Scope::PerDependency)->Arg(1000);
+BENCHMARK_TEMPLATE(BM_Bind_List, cdif::Scope::Singleton)->Arg(1000);
+BENCHMARK(BM_HandWired_Type);
+BENCHMARK(BM_HandWired_Interface);
+BENCHMARK(BM_HandWired_List);
+BENCHMARK_TEMPLATE(BM_HandWired_Depth, 1);
+BENCHMARK_TEMPLATE(BM_HandWired_Depth, 4);
+BENCHMARK_TEMPLATE(BM_HandWired_Depth, 16);
+BENCHMARK_TEMPLATE(BM_HandWired_Width, 1);
+BENCHMARK_TEMPLATE(BM_HandWired_Width, 4);
+BENCHMARK_TEMPLATE(BM_HandWired_Width, 16);
+
+BENCHMARK_TEMPLATE(BM_Resolve_Type, cdif::Scope::PerDependency)->ThreadRange(1, 8)->UseRealTime();
+BENCHMARK_TEMPLATE(BM_Resolve_Type, cdif::Scope::PerThread)->ThreadRange(1, 8)->UseRealTime();
+BENCHMARK_TEMPLATE(BM_Resolve_Type, cdif::Scope::Singleton)->ThreadRange(1, 8)->UseRealTime();
+BENCHMARK_TEMPLATE(BM_Resolve_Interface, cdif::Scope::PerDependency);
+BENCHMARK_TEMPLATE(BM_Resolve_Interface, cdif::Scope::PerThread);
+BENCHMARK_TEMPLATE(BM_Resolve_Interface, cdif::Scope::Singleton);
+BENCHMARK_TEMPLATE(BM_Resolve_Factory, cdif::Scope::PerDependency);
+BENCHMARK_TEMPLATE(BM_Resolve_Factory, cdif::Scope::PerThread);
+BENCHMARK_TEMPLATE(BM_Resolve_Factory, cdif::Scope::Singleton);
+BENCHMARK_TEMPLATE(BM_Resolve_List, cdif::Scope::PerDependency);
+BENCHMARK_TEMPLATE(BM_Resolve_List, cdif::Scope::PerThread);
+BENCHMARK_TEMPLATE(BM_Resolve_List, cdif::Scope::Singleton);
+BENCHMARK_TEMPLATE(BM_Resolve_ListAs, std::list<std::shared_ptr<IService>>);
+BENCHMARK_TEMPLATE(BM_Resolve_ListAs, std::array<std::shared_ptr<IService>, 2>);
+BENCHMARK_TEMPLATE(BM_Resolve_ListAs, std::pmr::vector<std::shared_ptr<IService>>);
+BENCHMARK(BM_Resolve_FirstOfList)->ArgName("lazy")->Arg(0)->Arg(1);
+BENCHMARK_TEMPLATE(BM_Resolve_SlowList, 8)->ArgName("parallel")->Arg(0)->Arg(1)->UseRealTime();
+BENCHMARK(BM_Static_Type);
+BENCHMARK(BM_Static_Interface);
+BENCHMARK(BM_Static_Singleton);
+BENCHMARK(BM_Resolve_Named);
+BENCHMARK(BM_Provider_Named);
+BENCHMARK(BM_Resolve_AlternatingPerThread);
+BENCHMARK(BM_Resolve_PooledSharedPtr);
+BENCHMARK(BM_Resolve_PooledUniquePtr);
+BENCHMARK_TEMPLATE(BM_Resolve_Depth, 1);
+BENCHMARK_TEMPLATE(BM_Resolve_Depth, 4);
+BENCHMARK_TEMPLATE(BM_Resolve_Depth, 16);
+BENCHMARK_TEMPLATE(BM_Resolve_Width, 1);
+BENCHMARK_TEMPLATE(BM_Resolve_Width, 4);
+BENCHMARK_TEMPLATE(BM_Resolve_Width, 16);
+BENCHMARK_TEMPLATE(BM_Request_PerDependency, 4);
+BENCHMARK_TEMPLATE(BM_Request_PerDependency, 16);
+BENCHMARK_TEMPLATE(BM_Request_PerScope, 4);
+BENCHMARK_TEMPLATE(BM_Request_PerScope, 16);
+BENCHMARK_TEMPLATE(BM_ColdResolve_FanOut, 8)->ArgName("async")->Arg(0)->Arg(1)->UseRealTime();
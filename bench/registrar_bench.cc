@@ -0,0 +1,158 @@
+#include <algorithm>
+#include <functional>
+#include <map>
+#include <memory>
+#include <random>
+#include <string>
+#include <typeinfo>
+#include <vector>
+
+#include <benchmark/benchmark.h>
+
+#include "cdif.h"
+
+namespace {
+    cdif::Registration createRegistration(size_t value)
+    {
+        std::function<size_t (const cdif::Container&)> resolver = [value] (const cdif::Container&) { return value; };
+        return cdif::Registration(resolver);
+    }
+
+    std::vector<size_t> shuffledIndices(size_t count)
+    {
+        auto indices = std::vector<size_t>(count);
+        for (size_t i = 0; i < count; i++)
+            indices[i] = i;
+        std::shuffle(indices.begin(), indices.end(), std::mt19937(42));
+        return indices;
+    }
+
+    std::string nameFor(size_t index)
+    {
+        return std::string(typeid(size_t).name()) + "Service" + std::to_string(index);
+    }
+}
+
+static void BM_StringMapLookup(benchmark::State& state)
+{
+    auto count = static_cast<size_t>(state.range(0));
+    auto registrations = std::map<std::string, std::unique_ptr<cdif::Registration>>();
+    auto names = std::vector<std::string>();
+    for (size_t i = 0; i < count; i++) {
+        names.push_back(nameFor(i));
+        registrations.insert_or_assign(names.back(), std::make_unique<cdif::Registration>(createRegistration(i)));
+    }
+    auto order = shuffledIndices(count);
+
+    size_t i = 0;
+    for (auto _ : state) {
+        auto it = registrations.find(names[order[i]]);
+        benchmark::DoNotOptimize(it->second.get());
+        i = (i + 1 == count) ? 0 : i + 1;
+    }
+}
+
+static void BM_RegistrarLookup(benchmark::State& state)
+{
+    auto count = static_cast<size_t>(state.range(0));
+    auto serviceNameFactory = cdif::ServiceNameFactory();
+    auto registrar = cdif::Registrar();
+    auto keys = std::vector<cdif::ServiceKey>();
+    for (size_t i = 0; i < count; i++) {
+        keys.push_back(serviceNameFactory.create<size_t>(nameFor(i)));
+        registrar.bind(createRegistration(i), keys.back());
+    }
+    auto order = shuffledIndices(count);
+
+    size_t i = 0;
+    for (auto _ : state) {
+        auto& registration = registrar.getRegistration<size_t>(keys[order[i]]);
+        benchmark::DoNotOptimize(&registration);
+        i = (i + 1 == count) ? 0 : i + 1;
+    }
+}
+
+static void BM_ContendedRegistrarLookup(benchmark::State& state)
+{
+    static auto registrar = cdif::Registrar();
+    static auto key = cdif::ServiceNameFactory().create<size_t>();
+
+    if (state.thread_index() == 0) {
+        registrar.unfreeze();
+        registrar.bind(createRegistration(0), key);
+        if (state.range(0) != 0)
+            registrar.freeze();
+    }
+
+    for (auto _ : state)
+        benchmark::DoNotOptimize(&registrar.getRegistration<size_t>(key));
+}
+
+// Thread 0 rebinds the key on every iteration while the other threads look
+// it up inside an epoch guard.
+static void BM_RegistrarLookupDuringRebind(benchmark::State& state)
+{
+    static auto registrar = cdif::Registrar();
+    static auto key = cdif::ServiceNameFactory().create<size_t>();
+
+    if (state.thread_index() == 0)
+        registrar.bind(createRegistration(0), key);
+
+    size_t i = 0;
+    for (auto _ : state) {
+        if (state.thread_index() == 0) {
+            registrar.bind(createRegistration(i++), key);
+            continue;
+        }
+
+        auto epoch = cdif::EpochGuard();
+        benchmark::DoNotOptimize(&registrar.getRegistration<size_t>(key));
+    }
+}
+
+// Binds the registrations after a lookup has published the table, like
+// startup code that resolves once and then keeps loading modules.
+static void BM_RegistrarBindAfterLookup(benchmark::State& state)
+{
+    auto count = static_cast<size_t>(state.range(0));
+    auto serviceNameFactory = cdif::ServiceNameFactory();
+    auto keys = std::vector<cdif::ServiceKey>();
+    for (size_t i = 0; i < count; i++)
+        keys.push_back(serviceNameFactory.create<size_t>(nameFor(i)));
+
+    for (auto _ : state) {
+        auto registrar = cdif::Registrar();
+        registrar.bind(createRegistration(0), keys[0]);
+        benchmark::DoNotOptimize(&registrar.getRegistration<size_t>(keys[0]));
+
+        for (size_t i = 1; i < count; i++)
+            registrar.bind(createRegistration(i), keys[i]);
+    }
+    state.SetItemsProcessed(state.iterations() * static_cast<int64_t>(count));
+}
+
+static void BM_RegistrationTableLookup(benchmark::State& state)
+{
+    auto count = static_cast<size_t>(state.range(0));
+    auto serviceNameFactory = cdif::ServiceNameFactory();
+    auto table = cdif::RegistrationTable();
+    auto keys = std::vector<cdif::ServiceKey>();
+    for (size_t i = 0; i < count; i++) {
+        keys.push_back(serviceNameFactory.create<size_t>(nameFor(i)));
+        table.insert_or_assign(keys.back(), createRegistration(i));
+    }
+    auto order = shuffledIndices(count);
+
+    size_t i = 0;
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(table.find(keys[order[i]]));
+        i = (i + 1 == count) ? 0 : i + 1;
+    }
+}
+
+BENCHMARK(BM_StringMapLookup)->Arg(100)->Arg(10000)->Arg(100000);
+BENCHMARK(BM_RegistrarLookup)->Arg(100)->Arg(10000)->Arg(100000);
+BENCHMARK(BM_ContendedRegistrarLookup)->ArgName("frozen")->Arg(0)->Arg(1)->ThreadRange(1, 8)->UseRealTime();
+BENCHMARK(BM_RegistrarLookupDuringRebind)->ThreadRange(2, 8)->UseRealTime();
+BENCHMARK(BM_RegistrarBindAfterLookup)->Arg(100)->Arg(1000)->Arg(10000);
+BENCHMARK(BM_RegistrationTableLookup)->Arg(100)->Arg(10000)->Arg(100000);
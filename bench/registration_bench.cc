@@ -0,0 +1,45 @@
+#include <functional>
+#include <memory>
+#include <string>
+
+#include <benchmark/benchmark.h>
+
+#include "cdif.h"
+
+static void BM_RegistrationResolveValue(benchmark::State& state)
+{
+    auto ctx = cdif::Container();
+    std::function<int (const cdif::Container&)> resolver = [] (const cdif::Container&) { return 42; };
+    auto registration = cdif::Registration(resolver);
+
+    for (auto _ : state)
+        benchmark::DoNotOptimize(registration.resolve<int>(ctx));
+}
+
+static void BM_RegistrationResolveLargeCapture(benchmark::State& state)
+{
+    auto ctx = cdif::Container();
+    auto prefix = std::string(64, 'x');
+    auto suffix = std::string(64, 'y');
+    std::function<size_t (const cdif::Container&)> resolver = [prefix, suffix] (const cdif::Container&)
+        {
+            return prefix.size() + suffix.size();
+        };
+    auto registration = cdif::Registration(resolver);
+
+    for (auto _ : state)
+        benchmark::DoNotOptimize(registration.resolve<size_t>(ctx));
+}
+
+static void BM_ContainerResolveValue(benchmark::State& state)
+{
+    auto ctx = cdif::Container();
+    ctx.bind<int>([] () { return 42; }).build();
+
+    for (auto _ : state)
+        benchmark::DoNotOptimize(ctx.resolve<int>());
+}
+
+BENCHMARK(BM_RegistrationResolveValue);
+BENCHMARK(BM_RegistrationResolveLargeCapture);
+BENCHMARK(BM_ContainerResolveValue);
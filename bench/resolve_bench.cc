@@ -0,0 +1,61 @@
+#include <memory>
+
+#include <benchmark/benchmark.h>
+
+#include "cdif.h"
+
+namespace {
+    struct Leaf
+    {
+        int m_value;
+
+        Leaf(int value) : m_value(value) {}
+    };
+
+    struct Root
+    {
+        std::shared_ptr<Leaf> m_left;
+        std::shared_ptr<Leaf> m_right;
+
+        Root(std::shared_ptr<Leaf> left, std::shared_ptr<Leaf> right)
+            : m_left(std::move(left)), m_right(std::move(right)) {}
+    };
+
+    cdif::Container createContainer()
+    {
+        auto ctx = cdif::Container();
+        ctx.bind<int>([] () { return 7; }).build();
+        ctx.bind<Leaf, int>().build();
+        ctx.bind<Root, std::shared_ptr<Leaf>, std::shared_ptr<Leaf>>().build();
+        return ctx;
+    }
+
+    cdif::Container& sharedContainer()
+    {
+        static auto container = createContainer();
+        return container;
+    }
+}
+
+static void BM_ResolveCompiled(benchmark::State& state)
+{
+    auto ctx = createContainer();
+    if (state.range(0) != 0)
+        ctx.compile();
+
+    for (auto _ : state)
+        benchmark::DoNotOptimize(ctx.resolve<Root>());
+}
+
+static void BM_ResolveScaling(benchmark::State& state)
+{
+    auto& ctx = sharedContainer();
+
+    for (auto _ : state)
+        benchmark::DoNotOptimize(ctx.resolve<Root>());
+
+    state.SetItemsProcessed(static_cast<int64_t>(state.iterations()));
+}
+
+BENCHMARK(BM_ResolveCompiled)->ArgName("compiled")->Arg(0)->Arg(1);
+BENCHMARK(BM_ResolveScaling)->ThreadRange(1, 16)->UseRealTime();
@@ -0,0 +1,82 @@
+#pragma once
+
+#include "cdif.h"
+
+#if defined(CDIF_COROUTINES)
+
+#include <functional>
+#include <memory>
+#include <string>
+#include <tuple>
+#include <utility>
+
+namespace cdif {
+    // Binds a coroutine factory returning Task<TReturn>. Its arguments are
+    // resolved with Container::resolveCo(), every one of them started before
+    // any is awaited. The service resolves through resolveCo() as TReturn,
+    // or as TReturn& in Scope::Singleton.
+    template <Scope TScope, typename TReturn, typename ... TArgs>
+    class AsyncFactoryRegistrationBuilder
+    {
+        static_assert(TScope == Scope::PerDependency || TScope == Scope::Singleton,
+            "Async factories are only supported in Scope::PerDependency and Scope::Singleton");
+
+        private:
+            typedef std::function<Task<TReturn> (TArgs...)> TFactory;
+
+            Container* m_ctx;
+            TFactory m_factory;
+            std::string m_name;
+
+            template <size_t ... Indices>
+            static Task<TReturn> create(const Container* ctx, TFactory factory, std::index_sequence<Indices...>)
+            {
+                auto arguments = std::tuple<Task<TArgs>...>(ctx->template resolveCo<TArgs>()...);
+                co_await detail::whenAllReady(arguments);
+                co_return co_await factory(std::get<Indices>(arguments).result()...);
+            }
+
+            static Task<TReturn> create(const Container* ctx, const TFactory& factory)
+            {
+                return create(ctx, factory, std::index_sequence_for<TArgs...>{});
+            }
+
+        public:
+            AsyncFactoryRegistrationBuilder(Container* ctx, const TFactory& factory, const std::string& name)
+                : m_ctx(ctx), m_factory(factory), m_name(name) {}
+
+            auto& named(const std::string& name)
+            {
+                m_name = name;
+                return *this;
+            }
+
+            template <Scope TNewScope>
+            auto in()
+            {
+                return AsyncFactoryRegistrationBuilder<TNewScope, TReturn, TArgs...>(m_ctx, m_factory, m_name);
+            }
+
+            void build()
+            {
+                auto factory = m_factory;
+                if constexpr (TScope == Scope::PerDependency) {
+                    std::function<Task<TReturn> (const Container&)> resolver = [factory] (const Container& ctx)
+                        {
+                            return create(&ctx, factory);
+                        };
+                    m_ctx->template bind<Task<TReturn>>(Registration(resolver), m_name);
+                } else {
+                    auto storage = std::make_shared<AsyncSingletonStorage<TReturn>>();
+                    std::function<Task<TReturn&> (const Container&)> resolver = [factory, storage] (const Container& ctx)
+                        {
+                            const Container* context = &ctx;
+                            return AsyncSingletonStorage<TReturn>::get(storage, [context, factory] () { return create(context, factory); });
+                        };
+                    m_ctx->template bind<Task<TReturn&>>(Registration(resolver), m_name);
+                }
+            }
+    };
+}
+
+#endif
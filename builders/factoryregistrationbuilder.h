@@ -2,9 +2,9 @@
 
 #include "cdif.h"
 
-#include <any>
-#include <array>
 #include <functional>
+#include <memory>
+#include <tuple>
 
 namespace cdif {
     template <Scope TScope, typename TReturn, typename ... TArgs>
@@ -14,50 +14,46 @@ namespace cdif {
             typedef std::function<TReturn (TArgs...)> TService;
             TService m_factory;
 
-            template <typename T>
-            constexpr auto getScopedFactoryFactory() const
-            {
-                if constexpr (TScope == Scope::Singleton)
-                    return createSingletonFactory<T, TArgs...>;
-                else if constexpr (TScope == Scope::PerThread)
-                    return createThreadLocalFactory<T, TArgs...>;
-            }
-
             void buildImpl()
             {
                 auto factoryCopy = m_factory;
                 std::function factory = [factoryCopy] (const Container&) { return factoryCopy; };
                 this->m_ctx->template bind<TService>(Registration(factory), this->m_name);
 
-                std::function valueFactory = [factoryCopy] (const Container& ctx)
+                auto resolvers = this->m_dependencyResolvers;
+                std::function valueFactory = [factoryCopy, resolvers] (const Container& ctx)
                 {
-                    return factoryCopy(std::forward<TArgs>(ctx.resolve<TArgs>())...);
+                    return std::apply([&ctx, &factoryCopy] (const auto& ... resolver)
+                        {
+                            return factoryCopy(std::forward<TArgs>(resolver(ctx))...);
+                        }, resolvers);
                 };
-                this->m_ctx->template bind<TReturn>(Registration(valueFactory), this->m_name);
+                this->m_ctx->template bind<TReturn>(Registration(valueFactory, this->dependencyLinks()), this->m_name);
             }
 
             template <typename T>
-            void buildScopedFactoryFrom(TService factory) const
+            void buildScopedFactoryFrom(TService factory, const std::shared_ptr<ScopedStorage<TScope, TReturn>>& storage) const
             {
-                auto scopedFactoryFactory = getScopedFactoryFactory<T>();
-                std::function scopedFactory = [factory, scopedFactoryFactory] (TArgs...args) -> T
+                std::function scopedFactory = [factory, storage] (TArgs...args) -> T
                 {
-                    return scopedFactoryFactory(factory, std::forward<TArgs>(args)...);
+                    return createScopedFactory<T>(factory, *storage, std::forward<TArgs>(args)...);
                 };
 
                 std::function f = [scopedFactory] (const Container&)
                 {
                     return scopedFactory;
                 };
-                this->m_ctx->template bind<std::function<T (TArgs...)>>(Registration(f), this->m_name);
+                this->m_ctx->template bind<std::function<T (TArgs...)>>(
+                    Registration(f, {}, nullptr, this->threadInstancesOf(storage)), this->m_name);
             }
 
 
             void buildScoped() const
             {
-                buildScopedFactoryFrom<TReturn&>(m_factory);
-                buildScopedFactoryFrom<TReturn*>(m_factory);
-                buildScopedFactoryFrom<std::shared_ptr<TReturn>>(m_factory);
+                auto storage = this->template buildStorage<TReturn>();
+                buildScopedFactoryFrom<TReturn&>(m_factory, storage);
+                buildScopedFactoryFrom<TReturn*>(m_factory, storage);
+                buildScopedFactoryFrom<std::shared_ptr<TReturn>>(m_factory, storage);
             }
 
         public:
@@ -2,9 +2,11 @@
 
 #include "cdif.h"
 
-#include <any>
-#include <array>
 #include <functional>
+#include <memory>
+#include <memory_resource>
+#include <tuple>
+#include <type_traits>
 #include <utility>
 
 namespace cdif {
@@ -12,69 +14,98 @@ namespace cdif {
     class InterfaceRegistrationBuilder : public RegistrationBuilder<TScope, TService, TCtorArgs...>
     {
         private:
-            typedef std::array<std::function<std::any ()>, sizeof...(TCtorArgs)> ResolverCollection;
+            typedef std::tuple<DependencyResolver<TCtorArgs>...> ResolverCollection;
 
-            template <typename TRet, typename Indices = std::make_index_sequence<sizeof...(TCtorArgs)>>
-            void buildRegistrationFrom(
-                const std::function<TRet (TCtorArgs&& ...)>& factory) const
+            typedef RegistrationBuilder<TScope, TService, TCtorArgs...> Base;
+
+            template <typename TRet>
+            static std::function<TRet (TCtorArgs&& ...)> factoryFor(std::pmr::memory_resource* resource)
             {
-                this->m_ctx->template bind<TRet>(
-                    Registration(this->buildResolverFrom(factory, Indices{})), this->m_name);
+                if constexpr (std::is_pointer_v<TRet>)
+                    return defaultInterfacePtrFactory<TService, TInterface, TCtorArgs...>();
+                else if constexpr (is_shared_ptr<TRet>)
+                    return defaultInterfaceSharedPtrFactory<TService, TInterface, TCtorArgs...>(resource);
+                else if constexpr (std::is_same_v<TRet, std::unique_ptr<TInterface>>)
+                    return defaultInterfaceUniquePtrFactory<TService, TInterface, TCtorArgs...>();
+                else
+                    return defaultInterfacePmrUniquePtrFactory<TService, TInterface, TCtorArgs...>(resource);
             }
 
-            template <typename TRet, typename TCasted>
-            void buildScopedRegistrationFrom(
-                const std::function<TService (const Container&)>& factory) const
+            static std::shared_ptr<const RegistrationVariants> buildFactoryVariants()
             {
-                this->m_ctx->template bind<TCasted>(
-                    Registration(buildScopedFactory<TRet, TCasted>(factory)), this->m_name);
+                return Base::template buildVariants<std::function<TService (TCtorArgs...)>>([] (auto)
+                    {
+                        return std::make_unique<Registration>(Base::buildFactoryResolver());
+                    });
             }
 
-            
+            // Registers TService with its factory derived from it, and
+            // TInterface with the pointers and smart pointers derived from it.
             template <typename Indices = std::make_index_sequence<sizeof...(TCtorArgs)>>
             void buildImpl() const
             {
-                buildRegistrationFrom<TService>(
-                    defaultFactory<TService, TCtorArgs...>());
-                buildRegistrationFrom<TInterface*>(
-                    defaultInterfacePtrFactory<TService, TInterface, TCtorArgs...>());
-                buildRegistrationFrom<std::shared_ptr<TInterface>>(
-                    defaultInterfaceSharedPtrFactory<TService, TInterface, TCtorArgs...>());
-                buildRegistrationFrom<std::unique_ptr<TInterface>>(
-                    defaultInterfaceUniquePtrFactory<TService, TInterface, TCtorArgs...>());
-
-                this->m_ctx->template bind<std::function<TService (TCtorArgs...)>>(
-                    Registration(this->buildFactoryResolver()), this->m_name);
-            }
-
-            template <typename T, typename TCasted>
-            std::function<TCasted (const Container&)> buildScopedFactory(
-                const std::function<TService (const Container&)>& resolver) const
-            {
-                std::function scopedFactory = this->template getScopedFactory<T>();
-                return [resolver, scopedFactory] (const Container& ctx) -> decltype(auto)
+                auto resolvers = this->m_dependencyResolvers;
+                auto links = this->dependencyLinks();
+                auto* resource = this->memoryResource();
+                auto interfaceVariants = Base::template buildVariants<
+                    TInterface*,
+                    std::shared_ptr<TInterface>,
+                    std::unique_ptr<TInterface>,
+                    pmr_unique_ptr<TInterface>>(
+                    [resolvers, links, resource] (auto variant)
                     {
-                        return static_cast<TCasted>(scopedFactory(resolver, ctx));
-                    };
+                        using TRet = typename decltype(variant)::type;
+                        return std::make_unique<Registration>(
+                            Base::buildResolverFrom(resolvers, factoryFor<TRet>(resource), Indices{}), links);
+                    });
+
+                this->m_ctx->template bind<TService>(
+                    Registration(this->buildResolverFrom(defaultFactory<TService, TCtorArgs...>(), Indices{}), links, nullptr, nullptr, buildFactoryVariants()),
+                    this->m_name);
+                this->m_ctx->template bind<TInterface>(Registration(interfaceVariants, links), this->m_name);
             }
 
+            // TInterface& is resolved from the scoped instance, TInterface*
+            // and std::shared_ptr<TInterface> are derived from it.
             template <typename Indices = std::make_index_sequence<sizeof...(TCtorArgs)>>
             void buildScoped() const
             {
                 auto resolver = this->buildResolverFrom(defaultFactory<TService, TCtorArgs...>(), Indices{});
-                
-                buildScopedRegistrationFrom<TService&, TService&>(resolver);
-                buildScopedRegistrationFrom<TService&, TInterface&>(resolver);
-                buildScopedRegistrationFrom<TService*, TInterface*>(resolver);
-                buildScopedRegistrationFrom<std::shared_ptr<TService>, std::shared_ptr<TInterface>>(resolver);
-                
-                this->m_ctx->template bind<std::function<TService (TCtorArgs...)>>(
-                    Registration(this->buildFactoryResolver()), this->m_name);
+                auto storage = this->template buildStorage<TService>();
+                auto initializer = this->buildInitializer(resolver, storage);
+                auto links = this->dependencyLinks();
+                auto threadInstances = this->threadInstancesOf(storage);
+                auto interfaceVariants = Base::template buildVariants<TInterface*, std::shared_ptr<TInterface>>(
+                    [resolver, storage, links, initializer, threadInstances] (auto variant)
+                    {
+                        using TCasted = typename decltype(variant)::type;
+                        using TRet = std::conditional_t<std::is_pointer_v<TCasted>, TService*, std::shared_ptr<TService>>;
+                        return std::make_unique<Registration>(
+                            Base::template buildScopedFactory<TRet, TCasted>(resolver, storage), links, initializer, threadInstances);
+                    });
+
+                this->m_ctx->template bind<TService>(
+                    Registration(
+                        Base::template buildScopedFactory<TService&>(resolver, storage),
+                        links,
+                        initializer,
+                        threadInstances,
+                        buildFactoryVariants()),
+                    this->m_name);
+                this->m_ctx->template bind<TInterface>(
+                    Registration(
+                        Base::template buildScopedFactory<TService&, TInterface&>(resolver, storage),
+                        links,
+                        initializer,
+                        threadInstances,
+                        interfaceVariants),
+                    this->m_name);
             }
         
         public:
-            InterfaceRegistrationBuilder(Container* ctx, ResolverCollection resolvers, std::string name)
-                : RegistrationBuilder<TScope, TService, TCtorArgs...>(ctx, resolvers, name)
+            InterfaceRegistrationBuilder(Container* ctx, ResolverCollection resolvers, std::string name,
+                std::pmr::memory_resource* memoryResource = nullptr)
+                : RegistrationBuilder<TScope, TService, TCtorArgs...>(ctx, resolvers, name, memoryResource)
             {
                 static_assert(has_constructor_with_args<TService, TCtorArgs...>::value,
                     "Cannot find constructor for service matching provided arguments");
@@ -99,7 +130,7 @@ namespace cdif {
             auto in()
             {
                 return InterfaceRegistrationBuilder<TNewScope, TService, TInterface, TCtorArgs...>(
-                    this->m_ctx, this->m_dependencyResolvers, this->m_name);
+                    this->m_ctx, this->m_dependencyResolvers, this->m_name, this->m_memoryResource);
             }
     };
 
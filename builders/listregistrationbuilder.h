@@ -2,11 +2,15 @@
 
 #include "cdif.h"
 
-#include <any>
 #include <array>
+#include <cstddef>
 #include <functional>
-#include <initializer_list>
 #include <list>
+#include <memory>
+#include <memory_resource>
+#include <string>
+#include <tuple>
+#include <type_traits>
 #include <utility>
 #include <vector>
 
@@ -15,76 +19,90 @@ namespace cdif {
     class ListRegistrationBuilder : public RegistrationBuilder<TScope, TService, TCtorArgs...>
     {
         private:
-            typedef std::array<std::function<std::any ()>, sizeof...(TCtorArgs)> ResolverCollection;
+            typedef RegistrationBuilder<TScope, TService, TCtorArgs...> Base;
+            typedef std::tuple<DependencyResolver<TCtorArgs>...> ResolverCollection;
 
-            template <typename T>
-            std::function<T (const Container&)> buildListResolverFor(const std::function<std::initializer_list<TService> (const Container&)>& initializerFactory) const
-            {
-                return [initializerFactory] (const Container& ctx) -> T
-                {
-                    return initializerFactory(ctx);
-                };
-            }
+            bool m_parallel;
 
-            template <typename TRet>
-            void buildRegistrationFrom(
-                const std::function<TRet (const Container&)>& factory) const
+            template <typename TList>
+            void buildScopedRegistrationFrom(const std::function<TList (const Container&)>& factory) const
             {
-                this->m_ctx->template bind<TRet>(Registration(factory), this->m_name);
+                auto storage = this->template buildStorage<TList>();
+                auto initializer = this->buildInitializer(factory, storage);
+                this->m_ctx->template bind<TList>(this->buildScopedRegistration(factory, storage, initializer), this->m_name);
             }
 
-            template <typename TRet, typename TBase = typename get_base_type<TRet>::type>
-            void buildScopedRegistrationFrom(
-                const std::function<TBase (const Container&)>& factory) const
+            template <size_t ... Indices>
+            static std::shared_ptr<const typename LazyList<TService>::ElementFactories> buildElementFactories(
+                const ResolverCollection& resolvers,
+                std::index_sequence<Indices...>)
             {
-                this->m_ctx->template bind<TRet>(Registration(buildScopedFactory<TRet>(factory)), this->m_name);
+                return std::make_shared<const typename LazyList<TService>::ElementFactories>(
+                    typename LazyList<TService>::ElementFactories {
+                        [resolvers] (const Container& ctx) -> TService
+                        {
+                            return TService(std::get<Indices>(resolvers)(ctx));
+                        }...
+                    });
             }
 
+            // Registers the vector, the other list types are derived from it
+            // when first requested.
             void buildImpl() const
             {
-                buildRegistrationFrom(buildListFrom<std::vector<TService>, TService, TCtorArgs...>(this->m_dependencyResolvers));
-                buildRegistrationFrom(buildListFrom<std::list<TService>, TService, TCtorArgs...>(this->m_dependencyResolvers));
-                buildRegistrationFrom(buildArrayFrom<std::array<TService, sizeof...(TCtorArgs)>, TService, TCtorArgs...>(this->m_dependencyResolvers));
-            }
+                auto resolvers = this->m_dependencyResolvers;
+                auto links = this->dependencyLinks();
+                auto* resource = this->memoryResource();
+                auto parallel = m_parallel;
+                auto variants = Base::template buildVariants<
+                    std::list<TService>,
+                    std::array<TService, sizeof...(TCtorArgs)>,
+                    std::pmr::vector<TService>,
+                    LazyList<TService>>(
+                    [resolvers, links, resource, parallel] (auto variant)
+                    {
+                        using TList = typename decltype(variant)::type;
+                        if constexpr (std::is_same_v<TList, LazyList<TService>>) {
+                            auto factories = buildElementFactories(resolvers, std::index_sequence_for<TCtorArgs...>{});
+                            return std::make_unique<Registration>(
+                                std::function<TList (const Container&)>([factories] (const Container& ctx)
+                                    {
+                                        return TList(ctx, factories);
+                                    }),
+                                links);
+                        } else if constexpr (std::is_same_v<TList, std::array<TService, sizeof...(TCtorArgs)>>) {
+                            return std::make_unique<Registration>(
+                                buildArrayFrom<TList, TService, TCtorArgs...>(resolvers), links);
+                        } else {
+                            return std::make_unique<Registration>(
+                                buildListFrom<TList, TService, TCtorArgs...>(resolvers, parallel, resource), links);
+                        }
+                    });
 
-            template <typename T, typename TBase = typename get_base_type<T>::type>
-            std::function<T (const Container&)> buildScopedFactory(
-                const std::function<TBase (const Container&)>& resolver) const
-            {
-                std::function scopedFactory = this->template getScopedFactory<T>();
-                return [resolver, scopedFactory] (const Container& ctx) -> decltype(auto) 
-                    { 
-                        return scopedFactory(resolver, ctx); 
-                    };
+                this->m_ctx->template bind<std::vector<TService>>(
+                    Registration(buildListFrom<std::vector<TService>, TService, TCtorArgs...>(resolvers, parallel),
+                        links, nullptr, nullptr, variants),
+                    this->m_name);
             }
 
             void buildScoped()
             {
-                auto vectorFactory = buildListFrom<std::vector<TService>, TService, TCtorArgs...>(this->m_dependencyResolvers);
-                buildScopedRegistrationFrom<std::vector<TService>&>(vectorFactory);
-                buildScopedRegistrationFrom<std::vector<TService>*>(vectorFactory);
-                buildScopedRegistrationFrom<std::shared_ptr<std::vector<TService>>>(vectorFactory);
-
-                auto listFactory = buildListFrom<std::list<TService>, TService, TCtorArgs...>(this->m_dependencyResolvers);
-                buildScopedRegistrationFrom<std::list<TService>&>(listFactory);
-                buildScopedRegistrationFrom<std::list<TService>*>(listFactory);
-                buildScopedRegistrationFrom<std::shared_ptr<std::list<TService>>>(listFactory);
-                
-                using arrayType = std::array<TService, sizeof...(TCtorArgs)>;
-                auto arrayFactory = buildArrayFrom<arrayType, TService, TCtorArgs...>(this->m_dependencyResolvers);
-                buildScopedRegistrationFrom<arrayType&>(arrayFactory);
-                buildScopedRegistrationFrom<arrayType*>(arrayFactory);
-                buildScopedRegistrationFrom<std::shared_ptr<arrayType>>(arrayFactory);
+                buildScopedRegistrationFrom(buildListFrom<std::vector<TService>, TService, TCtorArgs...>(this->m_dependencyResolvers, m_parallel));
+                buildScopedRegistrationFrom(buildListFrom<std::list<TService>, TService, TCtorArgs...>(this->m_dependencyResolvers, m_parallel));
+                buildScopedRegistrationFrom(buildArrayFrom<std::array<TService, sizeof...(TCtorArgs)>, TService, TCtorArgs...>(this->m_dependencyResolvers));
             }
             
         public:
             ListRegistrationBuilder(Container* ctx)
-                : RegistrationBuilder<TScope, TService, TCtorArgs...>(ctx)
+                : RegistrationBuilder<TScope, TService, TCtorArgs...>(ctx),
+                m_parallel(false)
             {
             }
 
-            ListRegistrationBuilder(Container* ctx, ResolverCollection resolvers, std::string name)
-                : RegistrationBuilder<TScope, TService, TCtorArgs...>(ctx, resolvers, name) {}
+            ListRegistrationBuilder(Container* ctx, ResolverCollection resolvers, std::string name,
+                std::pmr::memory_resource* memoryResource = nullptr, bool parallel = false)
+                : RegistrationBuilder<TScope, TService, TCtorArgs...>(ctx, resolvers, name, memoryResource),
+                m_parallel(parallel) {}
 
             virtual ~ListRegistrationBuilder() {}
             ListRegistrationBuilder (const ListRegistrationBuilder&) = default;
@@ -100,11 +118,22 @@ namespace cdif {
                     buildScoped();
             }
 
+            // Resolves the elements of each list concurrently on the shared
+            // thread pool. Worth it when the elements are slow to build. An
+            // element that reaches a Scope::PerThread registration is built
+            // again on the resolving thread once the others are done, so it
+            // gets that thread's instance rather than a worker's.
+            auto& inParallel()
+            {
+                m_parallel = true;
+                return *this;
+            }
+
             template <Scope TNewScope>
             auto in()
             {
                 return ListRegistrationBuilder<TNewScope, TService, TCtorArgs...>(
-                    this->m_ctx, this->m_dependencyResolvers, this->m_name);
+                    this->m_ctx, this->m_dependencyResolvers, this->m_name, this->m_memoryResource, m_parallel);
             }
     };
 }
@@ -2,72 +2,155 @@
 
 #include "cdif.h"
 
-#include <any>
-#include <array>
 #include <functional>
+#include <memory>
+#include <memory_resource>
 #include <string>
+#include <tuple>
+#include <typeinfo>
 #include <utility>
+#include <vector>
 
 namespace cdif {
-    template <typename TService>
-    static const std::function<std::any ()> defaultResolver()
-    {
-        return [] () -> std::function<TService (const Container&)>
-            {
-                return [] (const Container& ctx) -> TService { return ctx.template resolve<TService>(); };
-            };
-    }
-
     template <Scope TScope, typename TService, typename ... TCtorArgs>
     class RegistrationBuilder
     {
         protected:
-            typedef std::array<std::function<std::any ()>, sizeof...(TCtorArgs)> ResolverCollection;
+            typedef std::tuple<DependencyResolver<TCtorArgs>...> ResolverCollection;
 
             Container* m_ctx;
             ResolverCollection m_dependencyResolvers;
             std::string m_name;
+            std::pmr::memory_resource* m_memoryResource;
+
+            std::pmr::memory_resource* memoryResource() const
+            {
+                return (m_memoryResource != nullptr) ? m_memoryResource : m_ctx->memoryResource();
+            }
 
             template <typename TRet, size_t ... Indices>
-            std::function<TRet (const Container&)> buildResolverFrom(
+            static std::function<TRet (const Container&)> buildResolverFrom(
+                const ResolverCollection& resolvers,
                 const std::function<TRet (TCtorArgs&& ...)>& factory,
-                std::index_sequence<Indices...>) const
+                std::index_sequence<Indices...>)
             {
-                auto funcs = m_dependencyResolvers;
-                return [factory, funcs] (const Container& ctx) 
+                return [factory, resolvers] (const Container& ctx) 
                 { 
-                    return factory(std::forward<TCtorArgs>(
-                        getResolverAtIndex<TCtorArgs, Indices, sizeof...(TCtorArgs)>(funcs)(ctx))...);
+                    return factory(std::forward<TCtorArgs>(std::get<Indices>(resolvers)(ctx))...);
                 };
             }
 
-            std::function<std::function<TService (TCtorArgs...)> (const Container&)> buildFactoryResolver() const
+            template <typename TRet, size_t ... Indices>
+            std::function<TRet (const Container&)> buildResolverFrom(
+                const std::function<TRet (TCtorArgs&& ...)>& factory,
+                std::index_sequence<Indices...> indices) const
+            {
+                return buildResolverFrom(m_dependencyResolvers, factory, indices);
+            }
+
+            static std::function<std::function<TService (TCtorArgs...)> (const Container&)> buildFactoryResolver()
             {
                 return [] (const Container&) { return defaultFactory<TService, TCtorArgs...>(); };
             }
 
-            template <typename T>
-            constexpr auto& getScopedFactory() const
+            // The registration for each of TVariants is built by
+            // factory(type_identity<TVariant>()) when it is first requested.
+            template <typename ... TVariants, typename TFactory>
+            static std::shared_ptr<const RegistrationVariants> buildVariants(TFactory factory)
+            {
+                return std::make_shared<const RegistrationVariants>([factory] (TypeKey type)
+                    {
+                        auto registration = std::unique_ptr<Registration>();
+                        ( (type == type_key<TVariants> ? void(registration = factory(type_identity<TVariants>())) : void()), ... );
+                        return registration;
+                    },
+                    std::vector<TypeKey> { type_key<TVariants>... });
+            }
+
+            DependencyLinks dependencyLinks() const
+            {
+                return getDependencyLinks(m_dependencyResolvers);
+            }
+
+            template <typename T, typename TCasted = T, typename TBase = typename get_base_type<T>::type>
+            static std::function<TCasted (const Container&)> buildScopedFactory(
+                const std::function<TBase (const Container&)>& resolver,
+                const std::shared_ptr<ScopedStorage<TScope, TBase>>& storage)
+            {
+                return [resolver, storage] (const Container& ctx) -> TCasted
+                    {
+                        return static_cast<TCasted>(createScoped<T>(resolver, ctx, *storage));
+                    };
+            }
+
+            // Singletons are owned by the container, see SingletonInstances.
+            template <typename TBase>
+            std::shared_ptr<ScopedStorage<TScope, TBase>> buildStorage() const
             {
                 if constexpr (TScope == Scope::Singleton)
-                    return createSingleton<T>;
-                else if constexpr (TScope == Scope::PerThread)
-                    return createThreadLocal<T>;
+                    return std::make_shared<ScopedStorage<TScope, TBase>>(m_ctx->m_singletonInstances);
+                else
+                    return std::make_shared<ScopedStorage<TScope, TBase>>();
+            }
+
+            template <typename TBase>
+            std::shared_ptr<const SingletonInitializer> buildInitializer(
+                const std::function<TBase (const Container&)>& resolver,
+                const std::shared_ptr<ScopedStorage<TScope, TBase>>& storage) const
+            {
+                if constexpr (TScope != Scope::Singleton)
+                    return nullptr;
+                else
+                    return std::make_shared<const SingletonInitializer>(SingletonInitializer {
+                        typeid(TBase).name(),
+                        m_name,
+                        [resolver, storage] (const Container& ctx) { storage->get(resolver, ctx); }
+                    });
+            }
+
+            template <typename TBase>
+            static std::shared_ptr<ThreadInstanceStorage> threadInstancesOf(
+                const std::shared_ptr<ScopedStorage<TScope, TBase>>& storage)
+            {
+                if constexpr (TScope == Scope::PerThread)
+                    return storage;
+                else
+                    return nullptr;
+            }
+
+            // Resolves TBase& from the scoped instance, TBase* and
+            // std::shared_ptr<TBase> are derived from it.
+            template <typename TBase>
+            Registration buildScopedRegistration(
+                const std::function<TBase (const Container&)>& resolver,
+                const std::shared_ptr<ScopedStorage<TScope, TBase>>& storage,
+                const std::shared_ptr<const SingletonInitializer>& initializer) const
+            {
+                auto links = dependencyLinks();
+                auto threadInstances = threadInstancesOf(storage);
+                auto variants = buildVariants<TBase*, std::shared_ptr<TBase>>(
+                    [resolver, storage, links, initializer, threadInstances] (auto variant)
+                    {
+                        using T = typename decltype(variant)::type;
+                        return std::make_unique<Registration>(
+                            buildScopedFactory<T>(resolver, storage), links, initializer, threadInstances);
+                    });
+
+                return Registration(buildScopedFactory<TBase&>(resolver, storage), links, initializer, threadInstances, variants);
             }
 
         public:
             RegistrationBuilder(Container* ctx)
                 : m_ctx(ctx),
-                m_name()
+                m_dependencyResolvers(),
+                m_name(),
+                m_memoryResource(nullptr)
             {
-                m_dependencyResolvers = 
-                {
-                    defaultResolver<TCtorArgs>()...
-                };
             }
 
-            RegistrationBuilder(Container* ctx, ResolverCollection resolvers, std::string name)
-                : m_ctx(ctx), m_dependencyResolvers(resolvers), m_name(name) {}
+            RegistrationBuilder(Container* ctx, ResolverCollection resolvers, std::string name,
+                std::pmr::memory_resource* memoryResource = nullptr)
+                : m_ctx(ctx), m_dependencyResolvers(resolvers), m_name(name), m_memoryResource(memoryResource) {}
 
             virtual ~RegistrationBuilder() {}
             RegistrationBuilder(const RegistrationBuilder&) = default;
@@ -80,7 +163,7 @@ namespace cdif {
             {
                 static_assert(type_at_index_matches<Index, TDependency, TCtorArgs...>(),
                     "Constructor argument at that index does not match function return type");
-                m_dependencyResolvers[Index] = [resolver] () { return resolver; };
+                std::get<Index>(m_dependencyResolvers) = std::tuple_element_t<Index, ResolverCollection>(resolver);
                 return *this;
             }
 
@@ -90,18 +173,24 @@ namespace cdif {
                 return *this;
             }
 
+            auto& withMemoryResource(std::pmr::memory_resource* resource)
+            {
+                m_memoryResource = resource;
+                return *this;
+            }
+
             template <typename TInterface>
             auto as()
             {
                 return InterfaceRegistrationBuilder<TScope, TService, TInterface, TCtorArgs...>(
-                    m_ctx, m_dependencyResolvers, m_name);
+                    m_ctx, m_dependencyResolvers, m_name, m_memoryResource);
             }
 
             template <Scope TNewScope>
             auto in()
             {
                 return TypeRegistrationBuilder<TNewScope, TService, TCtorArgs...>(
-                    m_ctx, m_dependencyResolvers, m_name);
+                    m_ctx, m_dependencyResolvers, m_name, m_memoryResource);
             }
 
             virtual void build() = 0;
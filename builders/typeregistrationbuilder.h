@@ -2,9 +2,11 @@
 
 #include "cdif.h"
 
-#include <any>
-#include <array>
 #include <functional>
+#include <memory>
+#include <memory_resource>
+#include <tuple>
+#include <type_traits>
 #include <utility>
 
 namespace cdif {
@@ -12,55 +14,59 @@ namespace cdif {
     class TypeRegistrationBuilder : public RegistrationBuilder<TScope, TService, TCtorArgs...>
     {
         private:
-            typedef std::array<std::function<std::any ()>, sizeof...(TCtorArgs)> ResolverCollection;
+            typedef std::tuple<DependencyResolver<TCtorArgs>...> ResolverCollection;
 
-            template <typename TRet, typename Indices = std::make_index_sequence<sizeof...(TCtorArgs)>>
-            void buildRegistrationFrom(
-                const std::function<TRet (TCtorArgs&& ...)>& factory) const
-            {
-                this->m_ctx->template bind<TRet>(
-                    Registration(this->buildResolverFrom(factory, Indices{})), this->m_name);
-            }
+            typedef RegistrationBuilder<TScope, TService, TCtorArgs...> Base;
 
             template <typename TRet>
-            void buildScopedRegistrationFrom(
-                const std::function<TService (const Container&)>& factory) const
+            static std::function<TRet (TCtorArgs&& ...)> factoryFor(std::pmr::memory_resource* resource)
             {
-                this->m_ctx->template bind<TRet>(
-                    Registration(buildScopedFactory<TRet>(factory)), this->m_name);
+                if constexpr (std::is_pointer_v<TRet>)
+                    return defaultPtrFactory<TService, TCtorArgs...>();
+                else if constexpr (is_shared_ptr<TRet>)
+                    return defaultSharedPtrFactory<TService, TCtorArgs...>(resource);
+                else if constexpr (std::is_same_v<TRet, std::unique_ptr<TService>>)
+                    return defaultUniquePtrFactory<TService, TCtorArgs...>();
+                else
+                    return defaultPmrUniquePtrFactory<TService, TCtorArgs...>(resource);
             }
 
+            // Registers TService, the pointers, smart pointers and factory are
+            // derived from it when first requested.
             template <typename Indices = std::make_index_sequence<sizeof...(TCtorArgs)>>
             void buildImpl() const
             {
-                buildRegistrationFrom(defaultFactory<TService, TCtorArgs...>());
-                buildRegistrationFrom(defaultPtrFactory<TService, TCtorArgs...>());
-                buildRegistrationFrom(defaultSharedPtrFactory<TService, TCtorArgs...>());
-                buildRegistrationFrom(defaultUniquePtrFactory<TService, TCtorArgs...>());
+                auto resolvers = this->m_dependencyResolvers;
+                auto links = this->dependencyLinks();
+                auto* resource = this->memoryResource();
+                auto variants = Base::template buildVariants<
+                    TService*,
+                    std::shared_ptr<TService>,
+                    std::unique_ptr<TService>,
+                    pmr_unique_ptr<TService>,
+                    std::function<TService (TCtorArgs...)>>(
+                    [resolvers, links, resource] (auto variant)
+                    {
+                        using TRet = typename decltype(variant)::type;
+                        if constexpr (std::is_same_v<TRet, std::function<TService (TCtorArgs...)>>)
+                            return std::make_unique<Registration>(Base::buildFactoryResolver());
+                        else
+                            return std::make_unique<Registration>(
+                                Base::buildResolverFrom(resolvers, factoryFor<TRet>(resource), Indices{}), links);
+                    });
 
-                this->m_ctx->template bind<std::function<TService (TCtorArgs...)>>(
-                    Registration(this->buildFactoryResolver()),
+                this->m_ctx->template bind<TService>(
+                    Registration(this->buildResolverFrom(defaultFactory<TService, TCtorArgs...>(), Indices{}), links, nullptr, nullptr, variants),
                     this->m_name);
             }
 
-            template <typename T>
-            std::function<T (const Container&)> buildScopedFactory(
-                const std::function<TService (const Container&)>& resolver) const
-            {
-                std::function scopedFactory = this->template getScopedFactory<T>();
-                return [resolver, scopedFactory] (const Container& ctx) -> decltype(auto) 
-                    { 
-                        return scopedFactory(resolver, ctx); 
-                    };
-            }
-
             template <typename Indices = std::make_index_sequence<sizeof...(TCtorArgs)>>
             void buildScoped()
             {
                 auto resolver = this->buildResolverFrom(defaultFactory<TService, TCtorArgs...>(), Indices{});
-                buildScopedRegistrationFrom<TService&>(resolver);
-                buildScopedRegistrationFrom<TService*>(resolver);
-                buildScopedRegistrationFrom<std::shared_ptr<TService>>(resolver);
+                auto storage = this->template buildStorage<TService>();
+                auto initializer = this->buildInitializer(resolver, storage);
+                this->m_ctx->template bind<TService>(this->buildScopedRegistration(resolver, storage, initializer), this->m_name);
             }
             
         public:
@@ -71,8 +77,9 @@ namespace cdif {
                     "Cannot find constructor for service matching provided arguments");
             }
 
-            TypeRegistrationBuilder(Container* ctx, ResolverCollection resolvers, std::string name)
-                : RegistrationBuilder<TScope, TService, TCtorArgs...>(ctx, resolvers, name) {}
+            TypeRegistrationBuilder(Container* ctx, ResolverCollection resolvers, std::string name,
+                std::pmr::memory_resource* memoryResource = nullptr)
+                : RegistrationBuilder<TScope, TService, TCtorArgs...>(ctx, resolvers, name, memoryResource) {}
 
             virtual ~TypeRegistrationBuilder() {}
             TypeRegistrationBuilder (const TypeRegistrationBuilder&) = default;
@@ -92,7 +99,7 @@ namespace cdif {
             auto in()
             {
                 return TypeRegistrationBuilder<TNewScope, TService, TCtorArgs...>(
-                    this->m_ctx, this->m_dependencyResolvers, this->m_name);
+                    this->m_ctx, this->m_dependencyResolvers, this->m_name, this->m_memoryResource);
             }
     };
 }
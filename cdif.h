@@ -4,18 +4,26 @@ namespace cdif {
     class Container;
     class Registrar;
     class Registration;
+    class DependencyLink;
     class IModule;
     class ServiceNameFactory;
+    struct ServiceKey;
     class DependencyChainTracker;
     class PerThreadDependencyChainTracker;
+    class ThreadInstanceStorage;
+    class LifetimeScope;
 
     enum class Scope
     {
         PerDependency,
         PerThread,
-        Singleton
+        Singleton,
+        PerScope
     };
     
+    template <typename TDependency>
+    class DependencyResolver;
+
     template <Scope TScope, typename TService, typename ... TArgs>
     class RegistrationBuilder;
     
@@ -30,19 +38,43 @@ namespace cdif {
     
     template <Scope TScope, typename TService, typename ... TImplementations>
     class ListRegistrationBuilder;
+
+    template <typename T>
+    class Task;
+
+    template <Scope TScope, typename TReturn, typename ... TArgs>
+    class AsyncFactoryRegistrationBuilder;
 }
 
+// Coroutine factories and Container::resolveCo() are only available when
+// compiling as C++20 or later.
+#if defined(__cpp_impl_coroutine) && __has_include(<coroutine>)
+#define CDIF_COROUTINES
+#endif
+
 #include "type_traits.h"
 #include "typefactories.h"
 #include "scopedtypefactories.h"
+#include "servicenamefactory.h"
 #include "dependencychaintracker.h"
+#include "dependencygraph.h"
 #include "registration.h"
+#include "registrationtable.h"
+#include "epoch.h"
 #include "registrar.h"
+#include "threadpool.h"
+#include "warmup.h"
 #include "imodule.h"
-#include "servicenamefactory.h"
 #include "container.h"
+#include "lifetimescope.h"
+#include "lazy.h"
+#include "provider.h"
+#include "task.h"
+#include "staticcontainer.h"
+#include "dependencyresolver.h"
 #include "builders/registrationbuilder.h"
 #include "builders/typeregistrationbuilder.h"
 #include "builders/interfaceregistrationbuilder.h"
 #include "builders/factoryregistrationbuilder.h"
+#include "builders/asyncfactoryregistrationbuilder.h"
 #include "builders/listregistrationbuilder.h"
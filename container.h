@@ -1,11 +1,16 @@
 #pragma once
 
+#include <algorithm>
 #include <functional>
+#include <future>
 #include <memory>
+#include <memory_resource>
 #include <stdexcept>
 #include <string>
+#include <thread>
 #include <type_traits>
 #include <typeinfo>
+#include <vector>
 
 #include "cdif.h"
 
@@ -15,39 +20,130 @@ namespace cdif {
         private:
             static constexpr Scope DefaultScope = Scope::PerDependency;
 
+            template <typename T>
+            friend class Lazy;
+
+            template <typename T>
+            friend class Provider;
+
+            template <Scope TScope, typename TService, typename ... TArgs>
+            friend class RegistrationBuilder;
+
             std::unique_ptr<cdif::Registrar> m_registrar;
             std::unique_ptr<cdif::ServiceNameFactory> m_serviceNameFactory;
-            std::unique_ptr<cdif::PerThreadDependencyChainTracker> m_dependencyChain;
+            std::pmr::memory_resource* m_memoryResource;
+            std::shared_ptr<detail::SingletonInstances> m_singletonInstances;
+
+            void releaseSingletons()
+            {
+                if (m_singletonInstances != nullptr)
+                    m_singletonInstances->releaseAll();
+            }
+
+            template <typename TService>
+            DependencyChainGuard checkCircularDependencyResolution(const ServiceKey& key) const
+            {
+                auto& chain = PerThreadDependencyChainTracker::getThisChain();
+                if (chain.contains(this, key))
+                    throw std::runtime_error(std::string("Circular dependecy detected while resolving: ") + typeid(TService).name());
+
+                chain.push(this, key);
+                return DependencyChainGuard(chain);
+            }
+
+            template <typename TService>
+            TService unguardedResolve(const ServiceKey& key) const 
+            {
+                auto epoch = EpochGuard();
+                const Registration& registration = m_registrar->getRegistration<TService>(key);
+                return registration.resolve<TService>(*this);
+            }
+
+            template <typename TService>
+            TService resolveKey(const ServiceKey& key) const
+            {
+#if defined(CDIF_NO_RUNTIME_CYCLE_CHECK)
+                return unguardedResolve<TService>(key);
+#else
+                auto guard = checkCircularDependencyResolution<TService>(key);
+                return unguardedResolve<TService>(key);
+#endif
+            }
+
+            std::vector<std::shared_ptr<ThreadInstanceStorage>> threadInstanceStorages() const
+            {
+                auto storages = m_registrar->inspect([] (const RegistrationTable& registrations)
+                    {
+                        auto found = std::vector<std::shared_ptr<ThreadInstanceStorage>>();
+                        registrations.forEach([&found] (const ServiceKey&, const Registration& registration)
+                            {
+                                if (registration.threadInstances() != nullptr)
+                                    found.push_back(registration.threadInstances());
+                            });
+                        return found;
+                    });
 
-            void checkCircularDependencyResolution(const std::string & name) const
+                std::sort(storages.begin(), storages.end());
+                storages.erase(std::unique(storages.begin(), storages.end()), storages.end());
+                return storages;
+            }
+
+            template <typename TService>
+            TService resolveFrom(const Registration& registration, const ServiceKey& key) const
             {
-                auto count = m_dependencyChain->increment(name);
-                if (count > 1)
-                    throw std::runtime_error("Circular dependecy detected while resolving: " + name);
+#if defined(CDIF_NO_RUNTIME_CYCLE_CHECK)
+                (void)key;
+#else
+                auto guard = checkCircularDependencyResolution<TService>(key);
+#endif
+                return registration.resolve<TService>(*this);
             }
 
             template <typename TService>
-            TService unguardedResolve(const std::string& serviceName) const 
+            Provider<TService> providerFor(const ServiceKey& key) const
             {
-                const std::unique_ptr<Registration> & registration = m_registrar->getRegistration<TService>(serviceName);
-                return registration->resolve<TService>(*this);
+                return Provider<TService>(*this, m_registrar->getProviderLink(ServiceQuery::of<TService>(key), typeid(TService).name()));
             }
 
+#if defined(CDIF_COROUTINES)
+            template <typename TService>
+            Task<TService> resolveCoFrom(const ServiceKey& key) const;
+
+            template <typename TService>
+            static Task<TService> resolveNow(const Container* ctx, ServiceKey key);
+#endif
+
        public:
             Container() :
                     m_registrar(std::make_unique<cdif::Registrar>()),
                     m_serviceNameFactory(std::make_unique<cdif::ServiceNameFactory>()),
-                    m_dependencyChain(std::make_unique<cdif::PerThreadDependencyChainTracker>())
+                    m_memoryResource(nullptr),
+                    m_singletonInstances(std::make_shared<detail::SingletonInstances>())
                     {};
 
-            virtual ~Container() = default;
+            // Singletons are destroyed in reverse order of construction,
+            // before the registrations.
+            virtual ~Container()
+            {
+                releaseSingletons();
+            }
 
-            Container(Container&& other) : m_registrar(std::move(other.m_registrar)) {};
+            Container(Container&& other) :
+                    m_registrar(std::move(other.m_registrar)),
+                    m_serviceNameFactory(std::move(other.m_serviceNameFactory)),
+                    m_memoryResource(other.m_memoryResource),
+                    m_singletonInstances(std::move(other.m_singletonInstances))
+                    {};
 
             Container& operator=(Container&& other)
             {
-                if (this != &other)
+                if (this != &other) {
+                    releaseSingletons();
                     m_registrar = std::move(other.m_registrar);
+                    m_serviceNameFactory = std::move(other.m_serviceNameFactory);
+                    m_memoryResource = other.m_memoryResource;
+                    m_singletonInstances = std::move(other.m_singletonInstances);
+                }
                 return *this;
             }
 
@@ -65,6 +161,16 @@ namespace cdif {
                 return FactoryRegistrationBuilder<DefaultScope, remove_cvref_t<TReturn>, TArgs...>(this, factory, "");
             }
 
+#if defined(CDIF_COROUTINES)
+            template <typename TReturn,
+                typename ... TArgs,
+                typename Factory = std::function<Task<TReturn> (TArgs...)>>
+            auto bindAsync(const Factory& factory)
+            {
+                return AsyncFactoryRegistrationBuilder<DefaultScope, remove_cvref_t<TReturn>, TArgs...>(this, factory, "");
+            }
+#endif
+
             template <typename TService, typename ... TImplementations>
             auto bindList()
             {
@@ -74,8 +180,22 @@ namespace cdif {
             template <typename TService>
             void bind(const Registration& registration, const std::string& name)
             {
-                auto registrationName = m_serviceNameFactory->create<remove_cvref_t<TService>>(name);
-                m_registrar->bind(registration, registrationName);
+                auto key = m_serviceNameFactory->create<remove_cvref_t<TService>>(name);
+                m_registrar->bind(registration, key);
+            }
+
+            // Smart pointers built by PerDependency registrations bound after
+            // this call are allocated from the resource, unless the
+            // registration names its own. The resource must outlive every
+            // object allocated from it.
+            void setMemoryResource(std::pmr::memory_resource* resource)
+            {
+                m_memoryResource = resource;
+            }
+
+            std::pmr::memory_resource* memoryResource() const
+            {
+                return m_memoryResource;
             }
 
             template <typename TModule>
@@ -86,14 +206,178 @@ namespace cdif {
                 module.load(*this);
             }
 
+            // Named resolves no longer take a lock once frozen, see
+            // ServiceNameFactory::publish().
+            void freeze()
+            {
+                m_registrar->freeze();
+                m_serviceNameFactory->publish();
+            }
+
+            void compile()
+            {
+                m_registrar->compile();
+                m_serviceNameFactory->publish();
+            }
+
+            void unfreeze()
+            {
+                m_registrar->unfreeze();
+            }
+
+            bool isFrozen() const
+            {
+                return m_registrar->isFrozen();
+            }
+
+            // Each bind() adds one registration per service type, the pointer,
+            // smart pointer and factory forms derived from it are not counted.
+            size_t registrationCount() const
+            {
+                return m_registrar->inspect([] (const RegistrationTable& registrations)
+                    {
+                        return registrations.size();
+                    });
+            }
+
+            // Builds every singleton registration ahead of its first resolve,
+            // independent singletons in parallel. Returns how long each one
+            // took to build, slowest first. Singletons bound through a factory
+            // take their arguments at call time and are not warmed up.
+            // Singletons reached only through withIndexedParameterFrom() are
+            // not ordered, they are built on demand by the singleton using
+            // them.
+            std::vector<SingletonBuildTime> warmup(size_t threads = std::thread::hardware_concurrency()) const
+            {
+                auto singletons = m_registrar->inspect([] (const RegistrationTable& registrations)
+                    {
+                        return SingletonWarmup(registrations);
+                    });
+                return singletons.run(*this, threads);
+            }
+
+            // Builds the singletons TService depends on in parallel on the
+            // executor, independent ones at the same time and each exactly
+            // once, and then resolves TService on it. Errors, including a
+            // cycle between singletons, are reported through the future. The
+            // container must outlive the future. Dependencies given through
+            // withIndexedParameterFrom() are not followed, what they resolve
+            // is built on demand on the executor.
+            template <typename TService>
+            std::future<TService> resolveAsync(Executor executor) const
+            {
+                auto promise = std::make_shared<std::promise<TService>>();
+                auto result = promise->get_future();
+                try {
+                    auto key = m_serviceNameFactory->create<remove_cvref_t<TService>>();
+                    auto singletons = m_registrar->inspect([&key] (const RegistrationTable& registrations)
+                        {
+                            auto* registration = registrations.find(ServiceQuery::of<TService>(key));
+                            if (registration == nullptr)
+                                throw std::invalid_argument(std::string("Type not registered: ") + typeid(TService).name());
+                            return std::make_shared<const SingletonWarmup>(registrations, *registration);
+                        });
+
+                    singletons->start(*this, executor,
+                        [this, singletons, executor, key, promise] (std::exception_ptr error, std::vector<SingletonBuildTime>)
+                        {
+                            if (error) {
+                                promise->set_exception(error);
+                                return;
+                            }
+
+                            executor([this, key, promise] ()
+                                {
+                                    try {
+                                        promise->set_value(resolveKey<TService>(key));
+                                    } catch (...) {
+                                        promise->set_exception(std::current_exception());
+                                    }
+                                });
+                        });
+                } catch (...) {
+                    promise->set_exception(std::current_exception());
+                }
+                return result;
+            }
+
+            // Runs on the shared work-stealing pool.
+            template <typename TService>
+            std::future<TService> resolveAsync() const
+            {
+                return resolveAsync<TService>([] (std::function<void ()> task)
+                    {
+                        WorkStealingThreadPool::shared().submit(std::move(task));
+                    });
+            }
+
+            // Destroys the PerThread instances built on the given thread. A
+            // thread's instances are also released when it exits, call this
+            // when recycling a pool thread that keeps running. The thread must
+            // no longer be using its instances.
+            void releaseThread(std::thread::id thread = std::this_thread::get_id()) const
+            {
+                for (auto& storage : threadInstanceStorages())
+                    storage->release(thread);
+            }
+
+            // Destroys the PerThread instances of every thread. No thread may
+            // still be using its instances.
+            void releaseAllThreads() const
+            {
+                for (auto& storage : threadInstanceStorages())
+                    storage->releaseAll();
+            }
+
+            // Scope::PerScope services are shared within the returned scope and
+            // allocated from its arena, resolve them through the scope.
+            LifetimeScope beginScope() const;
+
+            // Returns a handle bound to the registration for TService, see
+            // Provider.
+            template <typename TService>
+            Provider<TService> provider() const
+            {
+                return providerFor<TService>(m_serviceNameFactory->create<remove_cvref_t<TService>>());
+            }
+
+            template <typename TService>
+            Provider<TService> provider(const std::string& name) const
+            {
+                return providerFor<TService>(m_serviceNameFactory->create<remove_cvref_t<TService>>(name));
+            }
+
+#if defined(CDIF_COROUTINES)
+            // Resolves TService from an async factory bound with bindAsync(),
+            // or, when there is none, resolves it synchronously once the task
+            // is awaited.
+            template <typename TService>
+            Task<TService> resolveCo() const;
+
+            template <typename TService>
+            Task<TService> resolveCo(const std::string& name) const;
+#endif
+
+            template <typename TService>
+            TService resolve() const
+            {
+                if constexpr (is_lazy<remove_cvref_t<TService>>)
+                    return TService(*this, m_serviceNameFactory->create<remove_cvref_t<typename TService::value_type>>());
+                else if constexpr (is_provider<remove_cvref_t<TService>>)
+                    return provider<typename TService::value_type>();
+                else
+                    return resolveKey<TService>(m_serviceNameFactory->create<remove_cvref_t<TService>>());
+            }
+
             template <typename TService>
-            TService resolve(const std::string& name = "") const
+            TService resolve(const std::string& name) const
             {
-                auto serviceName = m_serviceNameFactory->create<remove_cvref_t<TService>>(name);
-                checkCircularDependencyResolution(serviceName);
-                TService service = unguardedResolve<TService>(serviceName);
-                m_dependencyChain->clear(serviceName);
-                return service;
+                if constexpr (is_lazy<remove_cvref_t<TService>>)
+                    return TService(*this, m_serviceNameFactory->find<remove_cvref_t<typename TService::value_type>>(name));
+                else if constexpr (is_provider<remove_cvref_t<TService>>)
+                    return provider<typename TService::value_type>(name);
+                else
+                    return resolveKey<TService>(m_serviceNameFactory->find<remove_cvref_t<TService>>(name));
             }
     };
 }
@@ -1,98 +1,96 @@
 #pragma once
 
-#include <functional>
-#include <map>
-#include <memory>
-#include <mutex>
-#include <shared_mutex>
-#include <string>
-#include <thread>
+#include <array>
+#include <cstddef>
+#include <vector>
+
+#include "servicenamefactory.h"
 
 namespace cdif {
     class DependencyChainTracker
     {
         private:
-            std::map<std::string, size_t> m_dependencyChain;
+            struct Link
+            {
+                const void* owner;
+                ServiceKey key;
+            };
 
-        public:
-            DependencyChainTracker() : m_dependencyChain(std::map<std::string, size_t>()) {};
+            static constexpr size_t InlineDepth = 32;
+
+            std::array<Link, InlineDepth> m_inlineChain;
+            std::vector<Link> m_overflowChain;
+            size_t m_depth;
 
-            size_t increment(const std::string& name)
+            const Link& at(size_t index) const
             {
-                auto iter = m_dependencyChain.find(name);
-                auto value = (iter == m_dependencyChain.end()) ? static_cast<size_t>(0) : iter->second;
-                m_dependencyChain.insert_or_assign(name, ++value);
-                return value;
+                return (index < InlineDepth) ? m_inlineChain[index] : m_overflowChain[index - InlineDepth];
             }
 
-            void clear(const std::string& name)
+        public:
+            DependencyChainTracker() : m_inlineChain(), m_overflowChain(), m_depth(0) {};
+
+            bool contains(const void* owner, const ServiceKey& key) const
             {
-                m_dependencyChain.erase(name);
+                for (size_t i = 0; i < m_depth; i++) {
+                    auto& link = at(i);
+                    if (link.owner == owner && link.key == key)
+                        return true;
+                }
+                return false;
             }
 
-            bool isEmpty() const
+            void push(const void* owner, const ServiceKey& key)
             {
-                return m_dependencyChain.empty();
+                if (m_depth < InlineDepth)
+                    m_inlineChain[m_depth] = Link { owner, key };
+                else
+                    m_overflowChain.push_back(Link { owner, key });
+                m_depth++;
             }
-    };
 
-    class PerThreadDependencyChainTracker
-    {
-        private:
-            std::hash<std::thread::id> m_hasher;
-            mutable std::shared_mutex m_mutex;
-            std::map<size_t, std::unique_ptr<DependencyChainTracker>> m_threadChains;
-
-            size_t getThreadId() const
+            void pop()
             {
-                return m_hasher(std::this_thread::get_id());
+                m_depth--;
+                if (m_depth >= InlineDepth)
+                    m_overflowChain.pop_back();
             }
 
-            auto& getThisChain()
+            size_t depth() const
             {
-                auto id = getThreadId();
-
-                std::shared_lock<std::shared_mutex> readLock(m_mutex);
-                auto iter = m_threadChains.find(id);
-                if (iter == m_threadChains.end()) {
-                    readLock.unlock();
-                    createChain(id);
-                    readLock.lock();
-                    iter = m_threadChains.find(id);
-                }
-                
-                return iter->second;
+                return m_depth;
             }
 
-            void createChain(size_t id)
+            bool isEmpty() const
             {
-                std::unique_lock<std::shared_mutex> writeLock(m_mutex);
-                m_threadChains.insert_or_assign(id, std::make_unique<DependencyChainTracker>());
+                return m_depth == 0;
             }
+    };
+
+    class DependencyChainGuard
+    {
+        private:
+            DependencyChainTracker& m_chain;
 
         public:
-            PerThreadDependencyChainTracker() : m_threadChains(std::map<size_t, std::unique_ptr<DependencyChainTracker>>()) {};
+            DependencyChainGuard(DependencyChainTracker& chain) : m_chain(chain) {};
 
-            size_t increment(const std::string& name)
+            ~DependencyChainGuard()
             {
-                auto & chain = getThisChain();
-                return chain->increment(name);
+                m_chain.pop();
             }
 
-            void clear(const std::string & name)
-            {
-                auto & chain = getThisChain();
-                chain->clear(name);
-
-                if (chain->isEmpty()) {
-                    std::unique_lock<std::shared_mutex> writeLock(m_mutex);
-                    m_threadChains.erase(getThreadId());
-                }
-            }
+            DependencyChainGuard(const DependencyChainGuard&) = delete;
+            DependencyChainGuard& operator=(const DependencyChainGuard&) = delete;
+    };
 
-            bool isEmpty() const
+    class PerThreadDependencyChainTracker
+    {
+        public:
+            static DependencyChainTracker& getThisChain()
             {
-                return m_threadChains.empty();
+                thread_local DependencyChainTracker chain;
+                return chain;
             }
     };
 }
@@ -0,0 +1,85 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <type_traits>
+
+#include "type_traits.h"
+
+namespace cdif {
+    // Mirrors bind<TService, TDeps...>(). Dependencies are matched against
+    // other nodes by their base type, so std::shared_ptr<IFoo>, IFoo* and
+    // IFoo& all refer to the node for IFoo. Interface registrations are
+    // declared as a node from the interface to its implementation, e.g.
+    // DependencyNode<IFoo, Foo>.
+    template <typename TService, typename ... TDeps>
+    struct DependencyNode
+    {
+        using service_type = typename get_base_type<TService>::type;
+
+        template <typename T>
+        static constexpr bool depends_on = (std::is_same_v<typename get_base_type<TDeps>::type, T> || ...);
+    };
+
+    namespace detail {
+        template <typename ... TNodes>
+        class DependencyGraphAnalysis
+        {
+            private:
+                static constexpr size_t Size = sizeof...(TNodes);
+
+                using Matrix = std::array<std::array<bool, Size>, Size>;
+
+                template <typename TNode>
+                static constexpr std::array<bool, Size> edgesFrom()
+                {
+                    return { { TNode::template depends_on<typename TNodes::service_type>... } };
+                }
+
+                static constexpr Matrix reachability()
+                {
+                    Matrix reachable = { { edgesFrom<TNodes>()... } };
+
+                    for (size_t k = 0; k < Size; k++)
+                        for (size_t i = 0; i < Size; i++)
+                            for (size_t j = 0; j < Size; j++)
+                                if (reachable[i][k] && reachable[k][j])
+                                    reachable[i][j] = true;
+
+                    return reachable;
+                }
+
+            public:
+                static constexpr bool hasCycle()
+                {
+                    auto reachable = reachability();
+                    for (size_t i = 0; i < Size; i++)
+                        if (reachable[i][i])
+                            return true;
+                    return false;
+                }
+        };
+    }
+
+    // Naming a member of the graph (e.g. DependencyGraph<...>::is_acyclic)
+    // instantiates it and fails the build if the graph contains a cycle.
+    template <typename ... TNodes>
+    struct DependencyGraph
+    {
+        static constexpr bool is_acyclic = !detail::DependencyGraphAnalysis<TNodes...>::hasCycle();
+
+        static_assert(is_acyclic, "Circular dependency detected in dependency graph");
+    };
+
+    template <typename TGraph>
+    struct is_acyclic_graph;
+
+    template <typename ... TNodes>
+    struct is_acyclic_graph<DependencyGraph<TNodes...>>
+    {
+        static constexpr bool value = !detail::DependencyGraphAnalysis<TNodes...>::hasCycle();
+    };
+
+    template <typename TGraph>
+    inline constexpr bool is_acyclic_graph_v = is_acyclic_graph<TGraph>::value;
+}
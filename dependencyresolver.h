@@ -0,0 +1,95 @@
+#pragma once
+
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <typeinfo>
+#include <utility>
+
+#include "cdif.h"
+
+namespace cdif {
+    // Lazy<T> and Provider<T> dependencies are not linked, they are built by
+    // the container without a registration and resolve T only when used. A
+    // Provider<T> dependency keeps the link it was first handed, so later
+    // constructions build it without asking the registrar.
+    template <typename TDependency>
+    class DependencyResolver
+    {
+        private:
+            struct ProviderLinkCache
+            {
+                std::once_flag once;
+                std::shared_ptr<DependencyLink> link;
+            };
+
+            std::function<TDependency (const Container&)> m_resolver;
+            std::shared_ptr<DependencyLink> m_link;
+            std::shared_ptr<ProviderLinkCache> m_providerLink;
+
+            static std::shared_ptr<DependencyLink> defaultLink()
+            {
+                if constexpr (is_service_handle<remove_cvref_t<TDependency>>)
+                    return nullptr;
+                else
+                    return std::make_shared<DependencyLink>(
+                        ServiceQuery::of<TDependency>(
+                            ServiceKey { type_key<remove_cvref_t<TDependency>>, ServiceNameFactory::Unnamed }),
+                        typeid(TDependency).name());
+            }
+
+            static std::shared_ptr<ProviderLinkCache> defaultProviderLink()
+            {
+                if constexpr (is_provider<TDependency>)
+                    return std::make_shared<ProviderLinkCache>();
+                else
+                    return nullptr;
+            }
+
+        public:
+            DependencyResolver()
+                : m_resolver(),
+                m_link(defaultLink()),
+                m_providerLink(defaultProviderLink())
+            {};
+
+            DependencyResolver(std::function<TDependency (const Container&)> resolver)
+                : m_resolver(std::move(resolver)), m_link(), m_providerLink() {};
+
+            TDependency operator()(const Container& ctx) const
+            {
+                if (m_resolver)
+                    return m_resolver(ctx);
+
+                if constexpr (is_provider<TDependency>) {
+                    std::call_once(m_providerLink->once, [&] ()
+                        {
+                            m_providerLink->link = ctx.template resolve<TDependency>().m_link;
+                        });
+                    return TDependency(ctx, m_providerLink->link);
+                }
+
+                auto* target = m_link ? m_link->target() : nullptr;
+                if (target != nullptr)
+                    return target->template resolve<TDependency>(ctx);
+
+                return ctx.template resolve<TDependency>();
+            }
+
+            const std::shared_ptr<DependencyLink>& link() const
+            {
+                return m_link;
+            }
+    };
+
+    template <typename ... TDependencies>
+    DependencyLinks getDependencyLinks(const std::tuple<DependencyResolver<TDependencies>...>& resolvers)
+    {
+        auto links = DependencyLinks();
+        std::apply([&links] (const auto& ... resolver)
+            {
+                ( (resolver.link() ? links.push_back(resolver.link()) : void()), ... );
+            }, resolvers);
+        return links;
+    }
+}
@@ -0,0 +1,152 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+namespace cdif {
+    // Epoch based reclamation for data read without a lock. A reader
+    // announces the current epoch while it holds an EpochGuard. A writer
+    // replaces the data, advances the epoch and frees the old data once
+    // every reader has left the epoch it was retired in.
+    class EpochDomain
+    {
+        public:
+            static constexpr uint64_t Idle = 0;
+
+        private:
+            struct alignas(64) Reader
+            {
+                std::atomic<uint64_t> epoch;
+                std::atomic<bool> claimed;
+                Reader* next;
+
+                Reader(Reader* nextReader) : epoch(Idle), claimed(true), next(nextReader) {}
+            };
+
+            class ThreadReader
+            {
+                private:
+                    EpochDomain& m_domain;
+                    Reader* m_reader;
+                    size_t m_depth;
+
+                public:
+                    ThreadReader(EpochDomain& domain) : m_domain(domain), m_reader(domain.claim()), m_depth(0) {}
+
+                    ~ThreadReader()
+                    {
+                        m_reader->epoch.store(Idle, std::memory_order_release);
+                        m_reader->claimed.store(false, std::memory_order_release);
+                    }
+
+                    ThreadReader(const ThreadReader&) = delete;
+                    ThreadReader& operator=(const ThreadReader&) = delete;
+
+                    void enter()
+                    {
+                        if (m_depth++ == 0)
+                            m_reader->epoch.store(m_domain.m_epoch.load());
+                    }
+
+                    void exit()
+                    {
+                        if (--m_depth == 0)
+                            m_reader->epoch.store(Idle, std::memory_order_release);
+                    }
+            };
+
+            std::atomic<uint64_t> m_epoch;
+            std::atomic<Reader*> m_readers;
+
+            // Readers are never freed while the domain lives, a thread
+            // reuses the reader of a thread that has exited.
+            Reader* claim()
+            {
+                for (auto* reader = m_readers.load(); reader != nullptr; reader = reader->next) {
+                    auto claimed = false;
+                    if (reader->claimed.compare_exchange_strong(claimed, true))
+                        return reader;
+                }
+
+                auto* reader = new Reader(m_readers.load());
+                while (!m_readers.compare_exchange_weak(reader->next, reader)) {}
+                return reader;
+            }
+
+            static ThreadReader& thisThread()
+            {
+                thread_local ThreadReader reader(global());
+                return reader;
+            }
+
+            friend class EpochGuard;
+
+        public:
+            EpochDomain() : m_epoch(1), m_readers(nullptr) {}
+
+            ~EpochDomain()
+            {
+                for (auto* reader = m_readers.load(); reader != nullptr; ) {
+                    auto* next = reader->next;
+                    delete reader;
+                    reader = next;
+                }
+            }
+
+            EpochDomain(const EpochDomain&) = delete;
+            EpochDomain& operator=(const EpochDomain&) = delete;
+
+            static EpochDomain& global()
+            {
+                static EpochDomain domain;
+                return domain;
+            }
+
+            // Called after the old data has been unpublished. Returns the
+            // epoch to pass to isQuiescent() before freeing it.
+            uint64_t retire()
+            {
+                return m_epoch.fetch_add(1);
+            }
+
+            // True while any thread holds an EpochGuard.
+            bool hasActiveReaders() const
+            {
+                for (auto* reader = m_readers.load(); reader != nullptr; reader = reader->next)
+                    if (reader->epoch.load() != Idle)
+                        return true;
+                return false;
+            }
+
+            // True once no reader can still hold data retired in the epoch.
+            bool isQuiescent(uint64_t retired) const
+            {
+                for (auto* reader = m_readers.load(); reader != nullptr; reader = reader->next) {
+                    auto epoch = reader->epoch.load();
+                    if (epoch != Idle && epoch <= retired)
+                        return false;
+                }
+                return true;
+            }
+    };
+
+    // Marks a read-side critical section of the global epoch domain. Guards
+    // nest, only the outermost guard on a thread announces an epoch.
+    class EpochGuard
+    {
+        public:
+            EpochGuard()
+            {
+                EpochDomain::thisThread().enter();
+            }
+
+            ~EpochGuard()
+            {
+                EpochDomain::thisThread().exit();
+            }
+
+            EpochGuard(const EpochGuard&) = delete;
+            EpochGuard& operator=(const EpochGuard&) = delete;
+    };
+}
@@ -0,0 +1,211 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <functional>
+#include <iterator>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <type_traits>
+#include <vector>
+
+#include "cdif.h"
+
+namespace cdif {
+    // Acts as a pointer to a T that is resolved from the container the first
+    // time it is dereferenced. The container hands out a Lazy<T> for every
+    // registered T without a registration of its own, so Lazy<T> can be taken
+    // as a constructor argument to defer, or break a cycle through, a
+    // dependency. Copies share the resolved instance.
+    template <typename T>
+    class Lazy
+    {
+        private:
+            using Stored = std::conditional_t<std::is_reference_v<T>, std::remove_reference_t<T>*, T>;
+
+            struct State
+            {
+                const Container* container;
+                ServiceKey key;
+                std::once_flag resolved;
+                std::atomic<bool> created;
+                std::optional<Stored> value;
+
+                State(const Container* ctx, const ServiceKey& serviceKey)
+                    : container(ctx), key(serviceKey), resolved(), created(false), value() {}
+            };
+
+            std::shared_ptr<State> m_state;
+
+        public:
+            using value_type = T;
+
+            Lazy(const Container& ctx, const ServiceKey& key)
+                : m_state(std::make_shared<State>(&ctx, key)) {}
+
+            // If resolving throws, the next dereference tries again.
+            std::remove_reference_t<T>& get() const
+            {
+                auto& state = *m_state;
+                std::call_once(state.resolved, [&state] ()
+                    {
+                        if constexpr (std::is_reference_v<T>)
+                            state.value = &state.container->template resolveKey<T>(state.key);
+                        else
+                            state.value.emplace(state.container->template resolveKey<T>(state.key));
+                        state.created.store(true, std::memory_order_release);
+                    });
+
+                if constexpr (std::is_reference_v<T>)
+                    return **state.value;
+                else
+                    return *state.value;
+            }
+
+            std::remove_reference_t<T>& operator*() const
+            {
+                return get();
+            }
+
+            std::remove_reference_t<T>* operator->() const
+            {
+                return &get();
+            }
+
+            bool isCreated() const
+            {
+                return m_state->created.load(std::memory_order_acquire);
+            }
+    };
+
+    // A list bound with bindList() whose elements are each resolved the first
+    // time they are reached, so iteration that stops early never builds the
+    // rest. A reached element is kept for the life of the list and copies
+    // share it, create() builds a fresh one without keeping it. Resolved for
+    // PerDependency lists only, a scoped list is built once already.
+    template <typename T>
+    class LazyList
+    {
+        public:
+            typedef std::vector<std::function<T (const Container&)>> ElementFactories;
+
+        private:
+            struct Element
+            {
+                std::once_flag resolved;
+                std::atomic<bool> created;
+                std::optional<T> value;
+
+                Element() : resolved(), created(false), value() {}
+            };
+
+            struct State
+            {
+                const Container* container;
+                std::shared_ptr<const ElementFactories> factories;
+                std::unique_ptr<Element[]> elements;
+
+                State(const Container* ctx, std::shared_ptr<const ElementFactories> elementFactories)
+                    : container(ctx),
+                    factories(std::move(elementFactories)),
+                    elements(std::make_unique<Element[]>(factories->size())) {}
+            };
+
+            std::shared_ptr<State> m_state;
+
+            // If resolving throws, the next access tries again.
+            static T& elementAt(State& state, size_t index)
+            {
+                auto& element = state.elements[index];
+                std::call_once(element.resolved, [&state, &element, index] ()
+                    {
+                        element.value.emplace((*state.factories)[index](*state.container));
+                        element.created.store(true, std::memory_order_release);
+                    });
+                return *element.value;
+            }
+
+        public:
+            using value_type = T;
+
+            class iterator
+            {
+                private:
+                    State* m_state;
+                    size_t m_index;
+
+                public:
+                    using iterator_category = std::forward_iterator_tag;
+                    using value_type = T;
+                    using difference_type = std::ptrdiff_t;
+                    using pointer = T*;
+                    using reference = T&;
+
+                    iterator() : m_state(nullptr), m_index(0) {}
+                    iterator(State* state, size_t index) : m_state(state), m_index(index) {}
+
+                    T& operator*() const { return elementAt(*m_state, m_index); }
+                    T* operator->() const { return &elementAt(*m_state, m_index); }
+
+                    iterator& operator++()
+                    {
+                        m_index++;
+                        return *this;
+                    }
+
+                    iterator operator++(int)
+                    {
+                        auto previous = *this;
+                        m_index++;
+                        return previous;
+                    }
+
+                    bool operator==(const iterator& other) const { return m_index == other.m_index; }
+                    bool operator!=(const iterator& other) const { return m_index != other.m_index; }
+            };
+
+            LazyList(const Container& ctx, std::shared_ptr<const ElementFactories> factories)
+                : m_state(std::make_shared<State>(&ctx, std::move(factories))) {}
+
+            size_t size() const
+            {
+                return m_state->factories->size();
+            }
+
+            bool empty() const
+            {
+                return size() == 0;
+            }
+
+            T& at(size_t index) const
+            {
+                return elementAt(*m_state, index);
+            }
+
+            T& operator[](size_t index) const
+            {
+                return at(index);
+            }
+
+            T create(size_t index) const
+            {
+                return (*m_state->factories)[index](*m_state->container);
+            }
+
+            bool isCreated(size_t index) const
+            {
+                return m_state->elements[index].created.load(std::memory_order_acquire);
+            }
+
+            iterator begin() const
+            {
+                return iterator(m_state.get(), 0);
+            }
+
+            iterator end() const
+            {
+                return iterator(m_state.get(), size());
+            }
+    };
+}
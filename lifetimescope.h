@@ -0,0 +1,198 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <memory_resource>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "cdif.h"
+
+namespace cdif {
+    // Owns the Scope::PerScope instances resolved while it is the current
+    // scope of a thread. Instances are placed in a monotonic arena that starts
+    // in a buffer inside the scope, they are destroyed in reverse order of
+    // construction and their memory is released in one go when the scope
+    // ends.
+    //
+    // A scope is meant to be used by one thread at a time, e.g. the thread
+    // serving a request. Instances must not be captured by anything that
+    // outlives the scope, such as a singleton.
+    class LifetimeScope
+    {
+        private:
+            struct Instance
+            {
+                const void* key;
+                void* instance;
+                size_t owner;
+            };
+
+            static constexpr size_t InlineSize = 1024;
+            static constexpr size_t InitialCapacity = 16;
+
+            const Container* m_container;
+            alignas(std::max_align_t) std::byte m_buffer[InlineSize];
+            std::pmr::monotonic_buffer_resource m_arena;
+            std::pmr::vector<Instance> m_instances;
+            std::pmr::vector<std::shared_ptr<void>> m_owners;
+
+            // Open addressing with linear probing, a scope holds few instances
+            // and never removes any.
+            size_t slotOf(const void* key) const
+            {
+                auto mask = m_instances.size() - 1;
+                auto index = (reinterpret_cast<uintptr_t>(key) >> 4) * 0x9e3779b97f4a7c15ull;
+                for (auto slot = static_cast<size_t>(index >> 32) & mask; ; slot = (slot + 1) & mask)
+                    if (m_instances[slot].key == key || m_instances[slot].key == nullptr)
+                        return slot;
+            }
+
+            void grow()
+            {
+                auto instances = std::pmr::vector<Instance>(m_instances.size() * 2, Instance { nullptr, nullptr, 0 }, &m_arena);
+                instances.swap(m_instances);
+                for (auto& instance : instances)
+                    if (instance.key != nullptr)
+                        m_instances[slotOf(instance.key)] = instance;
+            }
+
+            // The instance and its shared_ptr control block share a single
+            // allocation from the arena.
+            template <typename T, typename TFactory, typename ... TArgs>
+            const Instance& instanceOf(const void* key, const TFactory& factory, TArgs&&... args)
+            {
+                auto slot = slotOf(key);
+                if (m_instances[slot].key != nullptr)
+                    return m_instances[slot];
+
+                auto owner = std::allocate_shared<T>(
+                    std::pmr::polymorphic_allocator<T>(&m_arena),
+                    factory(std::forward<TArgs>(args)...));
+                auto instance = Instance { key, owner.get(), m_owners.size() };
+                m_owners.push_back(std::move(owner));
+
+                if ((m_owners.size() * 2) > m_instances.size())
+                    grow();
+                return m_instances[slotOf(key)] = instance;
+            }
+
+            static LifetimeScope*& currentSlot()
+            {
+                thread_local LifetimeScope* current = nullptr;
+                return current;
+            }
+
+            class CurrentScopeGuard
+            {
+                private:
+                    LifetimeScope* m_previous;
+
+                public:
+                    explicit CurrentScopeGuard(LifetimeScope* scope) : m_previous(currentSlot())
+                    {
+                        currentSlot() = scope;
+                    }
+
+                    ~CurrentScopeGuard()
+                    {
+                        currentSlot() = m_previous;
+                    }
+
+                    CurrentScopeGuard(const CurrentScopeGuard&) = delete;
+                    CurrentScopeGuard& operator=(const CurrentScopeGuard&) = delete;
+            };
+
+        public:
+            explicit LifetimeScope(const Container& container)
+                : m_container(&container),
+                m_buffer(),
+                m_arena(m_buffer, InlineSize, std::pmr::new_delete_resource()),
+                m_instances(InitialCapacity, Instance { nullptr, nullptr, 0 }, &m_arena),
+                m_owners(&m_arena)
+            {
+                m_owners.reserve(InitialCapacity / 2);
+            }
+
+            ~LifetimeScope()
+            {
+                while (!m_owners.empty())
+                    m_owners.pop_back();
+            }
+
+            LifetimeScope(const LifetimeScope&) = delete;
+            LifetimeScope& operator=(const LifetimeScope&) = delete;
+
+            static LifetimeScope& current()
+            {
+                auto* scope = currentSlot();
+                if (scope == nullptr)
+                    throw std::logic_error("Scope::PerScope services can only be resolved through a LifetimeScope");
+                return *scope;
+            }
+
+            template <typename T, typename TFactory, typename ... TArgs>
+            T& get(const void* key, const TFactory& factory, TArgs&&... args)
+            {
+                return *static_cast<T*>(instanceOf<T>(key, factory, std::forward<TArgs>(args)...).instance);
+            }
+
+            template <typename T, typename TFactory, typename ... TArgs>
+            std::shared_ptr<T> getShared(const void* key, const TFactory& factory, TArgs&&... args)
+            {
+                auto owner = instanceOf<T>(key, factory, std::forward<TArgs>(args)...).owner;
+                return std::static_pointer_cast<T>(m_owners[owner]);
+            }
+
+            std::pmr::memory_resource* resource()
+            {
+                return &m_arena;
+            }
+
+            template <typename TService>
+            TService resolve()
+            {
+                auto guard = CurrentScopeGuard(this);
+                return m_container->resolve<TService>();
+            }
+
+            template <typename TService>
+            TService resolve(const std::string& name)
+            {
+                auto guard = CurrentScopeGuard(this);
+                return m_container->resolve<TService>(name);
+            }
+    };
+
+    // Owned by the registrations of a single bind(), its address identifies
+    // the instance within each LifetimeScope.
+    template <typename T>
+    class ScopedStorage<Scope::PerScope, T>
+    {
+        public:
+            ScopedStorage() {};
+
+            ScopedStorage(const ScopedStorage&) = delete;
+            ScopedStorage& operator=(const ScopedStorage&) = delete;
+
+            template <typename TFactory, typename ... TArgs>
+            T& get(const TFactory& factory, TArgs&&... args)
+            {
+                return LifetimeScope::current().template get<T>(this, factory, std::forward<TArgs>(args)...);
+            }
+
+            template <typename TFactory, typename ... TArgs>
+            std::shared_ptr<T> getShared(const TFactory& factory, TArgs&&... args)
+            {
+                return LifetimeScope::current().template getShared<T>(this, factory, std::forward<TArgs>(args)...);
+            }
+    };
+
+    inline LifetimeScope Container::beginScope() const
+    {
+        return LifetimeScope(*this);
+    }
+}
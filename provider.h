@@ -0,0 +1,50 @@
+#pragma once
+
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <utility>
+
+#include "cdif.h"
+
+namespace cdif {
+    // A handle to the registration bound to one key. Calling it runs the
+    // registration's factory without looking the key up, and it follows the
+    // key when it is rebound or the container is unfrozen. Calling it while
+    // nothing is bound to the key throws std::invalid_argument.
+    //
+    // The container hands out a Provider<T> for every T without a
+    // registration of its own, so it can also be taken as a constructor
+    // argument.
+    template <typename T>
+    class Provider
+    {
+        private:
+            template <typename TDependency>
+            friend class DependencyResolver;
+
+            const Container* m_container;
+            std::shared_ptr<DependencyLink> m_link;
+
+        public:
+            using value_type = T;
+
+            Provider(const Container& ctx, std::shared_ptr<DependencyLink> link)
+                : m_container(&ctx), m_link(std::move(link)) {}
+
+            T operator()() const
+            {
+                auto epoch = EpochGuard();
+                auto* registration = m_link->target();
+                if (registration == nullptr)
+                    throw std::invalid_argument(std::string("Type not registered: ") + m_link->typeName());
+
+                return m_container->template resolveFrom<T>(*registration, m_link->key());
+            }
+
+            bool isBound() const
+            {
+                return m_link->target() != nullptr;
+            }
+    };
+}
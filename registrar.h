@@ -1,59 +1,319 @@
 #pragma once
 
-#include <functional>
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
 #include <map>
 #include <memory>
 #include <mutex>
 #include <shared_mutex>
 #include <stdexcept>
 #include <string>
+#include <unordered_map>
 #include <utility>
+#include <vector>
 
 #include "cdif.h"
 
 namespace cdif {
     class Registrar {
         private:
-            std::map<std::string, std::unique_ptr<cdif::Registration>> m_registrations;
+            struct RetiredTable
+            {
+                uint64_t epoch;
+                std::unique_ptr<RegistrationTable> registrations;
+            };
+
+            std::unique_ptr<RegistrationTable> m_registrations;
+            // Published by const lookups, guarded by m_mutex like the table.
+            mutable std::atomic<const RegistrationTable*> m_publishedRegistrations;
+            std::vector<RetiredTable> m_retiredRegistrations;
+            std::map<ServiceQuery, std::weak_ptr<DependencyLink>> m_providerLinks;
+            std::atomic<bool> m_frozen;
             mutable std::shared_mutex m_mutex;
 
+            template <typename T>
+            static const cdif::Registration& find(const RegistrationTable& registrations, const ServiceKey& key)
+            {
+                auto* registration = registrations.find(ServiceQuery::of<T>(key));
+
+                if (registration == nullptr)
+                    throw std::invalid_argument(std::string("Type not registered: ") + typeid(T).name());
+
+                return *registration;
+            }
+
+            void linkDependencies(const RegistrationTable& registrations) const
+            {
+                auto missing = std::string();
+
+                registrations.forEach([&] (const ServiceKey&, const Registration& registration)
+                    {
+                        for (auto& dependency : registration.dependencies()) {
+                            auto* target = registrations.find(dependency->query());
+                            if (target == nullptr)
+                                missing += std::string(missing.empty() ? "" : ", ") + dependency->typeName();
+                            dependency->link(target);
+                        }
+                    });
+
+                if (!missing.empty()) {
+                    unlinkDependencies(registrations);
+                    throw std::invalid_argument("Type not registered: " + missing);
+                }
+            }
+
+            static void unlinkDependencies(const RegistrationTable& registrations)
+            {
+                registrations.forEach([] (const ServiceKey&, const Registration& registration)
+                    {
+                        for (auto& dependency : registration.dependencies())
+                            dependency->link(nullptr);
+                    });
+            }
+
+            static bool hasCycleFrom(const Registration& registration, std::unordered_map<const Registration*, bool>& visiting)
+            {
+                auto it = visiting.find(&registration);
+                if (it != visiting.end())
+                    return it->second;
+
+                visiting.emplace(&registration, true);
+                for (auto& dependency : registration.dependencies())
+                    if (hasCycleFrom(*dependency->target(), visiting))
+                        return true;
+                visiting[&registration] = false;
+
+                return false;
+            }
+
+            void checkCircularDependencies(const RegistrationTable& registrations) const
+            {
+                auto visiting = std::unordered_map<const Registration*, bool>();
+                auto hasCycle = false;
+
+                registrations.forEach([&] (const ServiceKey&, const Registration& registration)
+                    {
+                        hasCycle = hasCycle || hasCycleFrom(registration, visiting);
+                    });
+
+                if (hasCycle) {
+                    unlinkDependencies(registrations);
+                    throw std::runtime_error("Circular dependency detected while compiling registrations");
+                }
+            }
+
+            // Keeps provider links pointing at the registration currently
+            // resolving their query, dropping links that no provider holds any
+            // more.
+            void relinkProviders()
+            {
+                for (auto it = m_providerLinks.begin(); it != m_providerLinks.end(); ) {
+                    auto link = it->second.lock();
+                    if (link == nullptr) {
+                        it = m_providerLinks.erase(it);
+                        continue;
+                    }
+
+                    link->link(m_registrations->find(it->first));
+                    it++;
+                }
+            }
+
+            // Called with the write lock held by the first lookup, provider
+            // link or compile. Binds copy a published table while it may be
+            // read, see bind().
+            const RegistrationTable& publishLocked() const
+            {
+                auto* registrations = m_registrations.get();
+                m_publishedRegistrations.store(registrations);
+                return *registrations;
+            }
+
+            const RegistrationTable& publish() const
+            {
+                std::unique_lock<std::shared_mutex> lock(m_mutex);
+                return publishLocked();
+            }
+
+            const RegistrationTable& published() const
+            {
+                auto* registrations = m_publishedRegistrations.load();
+                if (registrations == nullptr)
+                    return publish();
+                return *registrations;
+            }
+
+            // Publishes a new table and retires the old one. Readers that
+            // may still hold the old table announced an epoch no later than
+            // the one it is retired in, and links are moved to the new table
+            // before the epoch advances.
+            void replace(std::unique_ptr<RegistrationTable> registrations)
+            {
+                auto retired = std::move(m_registrations);
+                m_registrations = std::move(registrations);
+                m_publishedRegistrations.store(m_registrations.get());
+                relinkProviders();
+                m_retiredRegistrations.push_back(RetiredTable { EpochDomain::global().retire(), std::move(retired) });
+                reclaimRetired();
+            }
+
+            void reclaimRetired()
+            {
+                auto& domain = EpochDomain::global();
+                m_retiredRegistrations.erase(
+                    std::remove_if(m_retiredRegistrations.begin(), m_retiredRegistrations.end(),
+                        [&domain] (const RetiredTable& retired) { return domain.isQuiescent(retired.epoch); }),
+                    m_retiredRegistrations.end());
+            }
+
+            void moveFrom(Registrar& other)
+            {
+                m_registrations = std::move(other.m_registrations);
+                m_retiredRegistrations = std::move(other.m_retiredRegistrations);
+                m_providerLinks = std::move(other.m_providerLinks);
+                m_publishedRegistrations.store(other.m_publishedRegistrations.exchange(nullptr));
+                m_frozen.store(other.m_frozen.exchange(false));
+            }
+
         public:
-            Registrar() : m_registrations(std::map<std::string, std::unique_ptr<cdif::Registration>>()) {};
+            Registrar()
+                : m_registrations(std::make_unique<RegistrationTable>()),
+                m_publishedRegistrations(nullptr),
+                m_retiredRegistrations(),
+                m_providerLinks(),
+                m_frozen(false) {};
 
             virtual ~Registrar() = default;
 
-            Registrar(Registrar&& other)
+            Registrar(Registrar&& other) : m_publishedRegistrations(nullptr), m_frozen(false)
             {
-                std::shared_lock<std::shared_mutex> lock(m_mutex);
-                m_registrations = std::move(other.m_registrations);
+                std::unique_lock<std::shared_mutex> lock(other.m_mutex);
+                moveFrom(other);
             }
 
             Registrar& operator=(Registrar&& other)
             {
                 if (this != &other) {
-                    std::shared_lock<std::shared_mutex> lock(m_mutex);
-                    m_registrations = std::move(other.m_registrations);
+                    std::scoped_lock lock(m_mutex, other.m_mutex);
+                    moveFrom(other);
                 }
                 return *this;
             }
 
+            // Never takes a lock once the table is published. The lookup holds
+            // its own EpochGuard, so binds do not modify the table under it.
+            // The registration stays valid while the calling thread holds an
+            // EpochGuard, binds on other threads retire it rather than modify
+            // it.
             template <typename T>
-            const std::unique_ptr<cdif::Registration>& getRegistration(const std::string& name) const
+            const cdif::Registration& getRegistration(const ServiceKey& key) const
             {
-                std::shared_lock<std::shared_mutex> lock(m_mutex);
-                auto it = m_registrations.find(name);
+                auto epoch = EpochGuard();
+                return find<T>(published(), key);
+            }
 
-                if (it == m_registrations.end())
-                    throw std::invalid_argument(std::string("Type not registered: ") + typeid(T).name());
+            // Like getRegistration(), but returns nullptr when nothing
+            // resolves T under the key.
+            template <typename T>
+            const cdif::Registration* findRegistration(const ServiceKey& key) const
+            {
+                auto epoch = EpochGuard();
+                return published().find(ServiceQuery::of<T>(key));
+            }
+
+            // Modifies the table in place unless another thread may be
+            // reading it. A published table is unpublished first, so lookups
+            // starting meanwhile wait for the write lock. If some thread holds
+            // an EpochGuard at that point, the whole table is copied and the
+            // old one retired instead, so binding n registrations while
+            // others resolve costs O(n^2). Startup code that resolves and
+            // then keeps binding only pays for the copy while a resolve is
+            // in progress.
+            void bind(const Registration& reg, const ServiceKey& key)
+            {
+                std::unique_lock<std::shared_mutex> lock(m_mutex);
+                if (isFrozen())
+                    throw std::logic_error("Cannot bind to a frozen registrar, call unfreeze() first");
+
+                auto* published = m_publishedRegistrations.exchange(nullptr);
+                if (published != nullptr && EpochDomain::global().hasActiveReaders()) {
+                    auto registrations = std::make_unique<RegistrationTable>(*m_registrations);
+                    registrations->insert_or_assign(key, reg);
+                    replace(std::move(registrations));
+                    return;
+                }
+
+                m_registrations->insert_or_assign(key, reg);
+                relinkProviders();
+                if (published != nullptr)
+                    m_publishedRegistrations.store(m_registrations.get());
+            }
 
-                return it->second;
+            // Returns the link shared by every provider of the query. It
+            // points at the registration currently resolving it, or at nothing
+            // while the type is not registered.
+            std::shared_ptr<DependencyLink> getProviderLink(const ServiceQuery& query, const char* typeName)
+            {
+                std::unique_lock<std::shared_mutex> lock(m_mutex);
+                auto& weakLink = m_providerLinks[query];
+                auto link = weakLink.lock();
+                if (link == nullptr) {
+                    link = std::make_shared<DependencyLink>(query, typeName);
+                    link->link(publishLocked().find(query));
+                    weakLink = link;
+                }
+                return link;
+            }
+
+            void freeze()
+            {
+                std::unique_lock<std::shared_mutex> lock(m_mutex);
+                m_frozen.store(true);
+            }
+
+            // Links every registration's dependencies directly to the
+            // registrations that satisfy them and then freezes the registrar.
+            void compile()
+            {
+                std::unique_lock<std::shared_mutex> lock(m_mutex);
+                auto& registrations = publishLocked();
+                linkDependencies(registrations);
+                checkCircularDependencies(registrations);
+                m_frozen.store(true);
             }
 
-            void bind(const Registration& reg, const std::string& name)
+            void unfreeze()
             {
                 std::unique_lock<std::shared_mutex> lock(m_mutex);
-                auto registration = std::make_unique<Registration>(reg);
-                m_registrations.insert_or_assign(name, std::move(registration));
+                if (!isFrozen())
+                    return;
+
+                unlinkDependencies(*m_registrations);
+                m_frozen.store(false);
+            }
+
+            // Frees retired tables that no reader can hold any more. Binds
+            // do this as they go, so this is only needed to release memory
+            // after the last rebind.
+            void reclaim()
+            {
+                std::unique_lock<std::shared_mutex> lock(m_mutex);
+                reclaimRetired();
+            }
+
+            // Holds a read lock for the duration of the visit, so the visitor
+            // must not bind to or resolve from the owning container.
+            template <typename TVisitor>
+            decltype(auto) inspect(TVisitor&& visitor) const
+            {
+                std::shared_lock<std::shared_mutex> lock(m_mutex);
+                return visitor(static_cast<const RegistrationTable&>(*m_registrations));
+            }
+
+            bool isFrozen() const
+            {
+                return m_frozen.load(std::memory_order_acquire);
             }
     };
 }
@@ -1,24 +1,110 @@
 #pragma once
 
 #include <any>
+#include <array>
+#include <atomic>
+#include <cstddef>
 #include <functional>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <string>
 #include <type_traits>
+#include <utility>
+#include <vector>
 
 #include "cdif.h"
 
 namespace cdif {
-    class Registration
+    class DependencyLink
     {
         private:
-            std::function<std::any(const Container&)> m_resolver;
+            ServiceQuery m_query;
+            const char* m_typeName;
+            std::atomic<const Registration*> m_target;
 
         public:
-            template <typename T>
-            Registration(const std::function<T (const Container&)>& resolver)
+            DependencyLink(const ServiceQuery& query, const char* typeName)
+                : m_query(query), m_typeName(typeName), m_target(nullptr) {};
+
+            const ServiceQuery& query() const
+            {
+                return m_query;
+            }
+
+            const ServiceKey& key() const
             {
-                m_resolver = [resolver] (const Container&) { return resolver; };
+                return m_query.key;
             }
 
+            const char* typeName() const
+            {
+                return m_typeName;
+            }
+
+            const Registration* target() const
+            {
+                return m_target.load();
+            }
+
+            void link(const Registration* target)
+            {
+                m_target.store(target);
+            }
+    };
+
+    typedef std::vector<std::shared_ptr<DependencyLink>> DependencyLinks;
+
+    // Builds the instance behind a singleton registration ahead of its first
+    // resolve. Every registration made by one bind() shares one initializer,
+    // which is how Container::warmup() builds each instance exactly once.
+    struct SingletonInitializer
+    {
+        const char* typeName;
+        std::string name;
+        std::function<void (const Container&)> initialize;
+    };
+
+    class RegistrationVariants;
+
+    class Registration
+    {
+        private:
+            TypeKey m_type;
+            std::shared_ptr<const void> m_resolver;
+            DependencyLinks m_dependencies;
+            std::shared_ptr<const SingletonInitializer> m_initializer;
+            std::shared_ptr<ThreadInstanceStorage> m_threadInstances;
+            std::shared_ptr<const RegistrationVariants> m_variants;
+
+        public:
+            template <typename T>
+            Registration(const std::function<T (const Container&)>& resolver,
+                DependencyLinks dependencies = {},
+                std::shared_ptr<const SingletonInitializer> initializer = nullptr,
+                std::shared_ptr<ThreadInstanceStorage> threadInstances = nullptr,
+                std::shared_ptr<const RegistrationVariants> variants = nullptr)
+                : m_type(type_key<T>),
+                m_resolver(std::make_shared<const std::function<T (const Container&)>>(resolver)),
+                m_dependencies(std::move(dependencies)),
+                m_initializer(std::move(initializer)),
+                m_threadInstances(std::move(threadInstances)),
+                m_variants(std::move(variants))
+            {}
+
+            // Resolves nothing itself, only the variants derived from it.
+            Registration(std::shared_ptr<const RegistrationVariants> variants,
+                DependencyLinks dependencies = {},
+                std::shared_ptr<const SingletonInitializer> initializer = nullptr,
+                std::shared_ptr<ThreadInstanceStorage> threadInstances = nullptr)
+                : m_type(nullptr),
+                m_resolver(),
+                m_dependencies(std::move(dependencies)),
+                m_initializer(std::move(initializer)),
+                m_threadInstances(std::move(threadInstances)),
+                m_variants(std::move(variants))
+            {}
+
             virtual ~Registration() = default;
 
             Registration(const Registration&) = default;
@@ -29,8 +115,127 @@ namespace cdif {
             template <typename T>
             T resolve(const cdif::Container& ctx) const
             {
-                auto resolver = std::any_cast<std::function<T (const Container&)>>(m_resolver(ctx));
+                if (m_type != type_key<T>)
+                    throw std::bad_any_cast();
+
+                auto& resolver = *static_cast<const std::function<T (const Container&)>*>(m_resolver.get());
                 return resolver(ctx);
             }
+
+            const DependencyLinks& dependencies() const
+            {
+                return m_dependencies;
+            }
+
+            const std::shared_ptr<const SingletonInitializer>& initializer() const
+            {
+                return m_initializer;
+            }
+
+            const std::shared_ptr<ThreadInstanceStorage>& threadInstances() const
+            {
+                return m_threadInstances;
+            }
+
+            bool hasVariants() const
+            {
+                return m_variants != nullptr;
+            }
+
+            // The types of the variants derived from this registration.
+            const std::vector<TypeKey>& variantTypes() const;
+
+            // Returns the registration resolving the given type, this one or
+            // a variant derived from it, or nullptr when the bind behind this
+            // registration does not resolve that type.
+            const Registration* variant(TypeKey type) const;
     };
+
+    // The other forms of the service a bind() resolves as, derived from its
+    // canonical registration. A variant's registration is only built the
+    // first time that form is requested and it lives as long as the bind's
+    // registrations, after that it is found without taking a lock.
+    class RegistrationVariants
+    {
+        public:
+            typedef std::function<std::unique_ptr<Registration> (TypeKey)> Materializer;
+
+        private:
+            static constexpr size_t MaxVariants = 8;
+
+            struct Variant
+            {
+                TypeKey type;
+                std::unique_ptr<Registration> registration;
+            };
+
+            Materializer m_materialize;
+            std::vector<TypeKey> m_types;
+            mutable std::array<Variant, MaxVariants> m_variants;
+            mutable std::atomic<size_t> m_size;
+            mutable std::mutex m_mutex;
+
+            const Registration* findBuilt(TypeKey type, size_t size) const
+            {
+                for (size_t i = 0; i < size; i++)
+                    if (m_variants[i].type == type)
+                        return m_variants[i].registration.get();
+                return nullptr;
+            }
+
+        public:
+            // Types are the variants the materializer builds, a bind under
+            // the canonical key replaces earlier binds of them.
+            explicit RegistrationVariants(Materializer materialize, std::vector<TypeKey> types = {})
+                : m_materialize(std::move(materialize)), m_types(std::move(types)), m_variants(), m_size(0), m_mutex() {}
+
+            RegistrationVariants(const RegistrationVariants&) = delete;
+            RegistrationVariants& operator=(const RegistrationVariants&) = delete;
+
+            const Registration* find(TypeKey type) const
+            {
+                auto* registration = findBuilt(type, m_size.load(std::memory_order_acquire));
+                if (registration != nullptr)
+                    return registration;
+
+                std::lock_guard<std::mutex> lock(m_mutex);
+                auto size = m_size.load(std::memory_order_relaxed);
+                registration = findBuilt(type, size);
+                if (registration != nullptr)
+                    return registration;
+
+                auto built = m_materialize(type);
+                if (built == nullptr)
+                    return nullptr;
+                if (size == MaxVariants)
+                    throw std::logic_error("Too many variants derived from one registration");
+
+                m_variants[size] = Variant { type, std::move(built) };
+                m_size.store(size + 1, std::memory_order_release);
+                return m_variants[size].registration.get();
+            }
+
+            size_t size() const
+            {
+                return m_size.load(std::memory_order_acquire);
+            }
+
+            const std::vector<TypeKey>& types() const
+            {
+                return m_types;
+            }
+    };
+
+    inline const std::vector<TypeKey>& Registration::variantTypes() const
+    {
+        static const std::vector<TypeKey> none;
+        return (m_variants == nullptr) ? none : m_variants->types();
+    }
+
+    inline const Registration* Registration::variant(TypeKey type) const
+    {
+        if (m_type == type)
+            return this;
+        return (m_variants == nullptr) ? nullptr : m_variants->find(type);
+    }
 }
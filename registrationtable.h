@@ -0,0 +1,238 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <utility>
+#include <vector>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+#include "cdif.h"
+
+namespace cdif {
+    class RegistrationTable
+    {
+        private:
+            static constexpr size_t GroupWidth = 16;
+            static constexpr int8_t EmptySlot = -128;
+            static constexpr int8_t ErasedSlot = -1;
+
+            struct Slot
+            {
+                ServiceKey key;
+                Registration* registration;
+            };
+
+            std::vector<int8_t> m_control;
+            std::vector<Slot> m_slots;
+            std::deque<Registration> m_registrations;
+            size_t m_groupMask;
+            size_t m_size;
+            size_t m_erased;
+
+            static size_t hash(const ServiceKey& key)
+            {
+                auto h = static_cast<uint64_t>(reinterpret_cast<uintptr_t>(key.type));
+                h ^= static_cast<uint64_t>(key.name) * 0x9e3779b97f4a7c15ull;
+                h = (h ^ (h >> 30)) * 0xbf58476d1ce4e5b9ull;
+                h = (h ^ (h >> 27)) * 0x94d049bb133111ebull;
+                return static_cast<size_t>(h ^ (h >> 31));
+            }
+
+            static int8_t controlByteOf(size_t hash)
+            {
+                return static_cast<int8_t>(hash & 0x7f);
+            }
+
+            static bool isFull(int8_t control)
+            {
+                return control >= 0;
+            }
+
+            static uint32_t matchByte(const int8_t* group, int8_t value)
+            {
+#if defined(__SSE2__)
+                auto control = _mm_loadu_si128(reinterpret_cast<const __m128i*>(group));
+                auto matches = _mm_cmpeq_epi8(control, _mm_set1_epi8(value));
+                return static_cast<uint32_t>(_mm_movemask_epi8(matches));
+#else
+                uint32_t mask = 0;
+                for (size_t i = 0; i < GroupWidth; i++)
+                    mask |= static_cast<uint32_t>(group[i] == value) << i;
+                return mask;
+#endif
+            }
+
+            static size_t lowestBit(uint32_t mask)
+            {
+                return static_cast<size_t>(__builtin_ctz(mask));
+            }
+
+            size_t capacity() const
+            {
+                return m_slots.size();
+            }
+
+            template <typename TVisitor>
+            const Slot* probe(const ServiceKey& key, size_t h, TVisitor&& onEmpty) const
+            {
+                auto tag = controlByteOf(h);
+                auto group = (h >> 7) & m_groupMask;
+
+                for (size_t step = 1; ; step++) {
+                    auto* control = m_control.data() + group * GroupWidth;
+
+                    for (auto mask = matchByte(control, tag); mask != 0; mask &= mask - 1) {
+                        auto& slot = m_slots[group * GroupWidth + lowestBit(mask)];
+                        if (slot.key == key)
+                            return &slot;
+                    }
+
+                    auto empties = matchByte(control, EmptySlot);
+                    if (empties != 0) {
+                        onEmpty(group * GroupWidth + lowestBit(empties));
+                        return nullptr;
+                    }
+
+                    group = (group + step) & m_groupMask;
+                }
+            }
+
+            void insertNew(const ServiceKey& key, Registration* registration)
+            {
+                auto h = hash(key);
+                probe(key, h, [&] (size_t index)
+                    {
+                        m_control[index] = controlByteOf(h);
+                        m_slots[index] = Slot { key, registration };
+                    });
+                m_size++;
+            }
+
+            void rehash(size_t groupCount)
+            {
+                auto slots = std::move(m_slots);
+                auto control = std::move(m_control);
+
+                m_control.assign(groupCount * GroupWidth, EmptySlot);
+                m_slots.assign(groupCount * GroupWidth, Slot { ServiceKey { nullptr, 0 }, nullptr });
+                m_groupMask = groupCount - 1;
+                m_size = 0;
+                m_erased = 0;
+
+                for (size_t i = 0; i < control.size(); i++)
+                    if (isFull(control[i]))
+                        insertNew(slots[i].key, slots[i].registration);
+            }
+
+            void assign(const ServiceKey& key, const Registration& registration)
+            {
+                auto* slot = probe(key, hash(key), [] (size_t) {});
+                if (slot != nullptr) {
+                    *slot->registration = registration;
+                    return;
+                }
+
+                // Erased slots still end probes late, so they count towards
+                // the load until a rehash drops them.
+                if ((m_size + m_erased + 1) * 8 > capacity() * 7)
+                    rehash(((m_size + 1) * 16 > capacity() * 7) ? (m_groupMask + 1) * 2 : m_groupMask + 1);
+
+                m_registrations.push_back(registration);
+                insertNew(key, &m_registrations.back());
+            }
+
+        public:
+            RegistrationTable()
+                : m_control(GroupWidth, EmptySlot),
+                m_slots(GroupWidth, Slot { ServiceKey { nullptr, 0 }, nullptr }),
+                m_registrations(),
+                m_groupMask(0),
+                m_size(0),
+                m_erased(0)
+            {}
+
+            RegistrationTable(const RegistrationTable& other)
+                : RegistrationTable()
+            {
+                for (size_t i = 0; i < other.m_control.size(); i++)
+                    if (isFull(other.m_control[i]))
+                        assign(other.m_slots[i].key, *other.m_slots[i].registration);
+            }
+
+            RegistrationTable& operator=(const RegistrationTable&) = delete;
+            RegistrationTable(RegistrationTable&&) = default;
+            RegistrationTable& operator=(RegistrationTable&&) = default;
+
+            const Registration* find(const ServiceKey& key) const
+            {
+                auto* slot = probe(key, hash(key), [] (size_t) {});
+                return (slot == nullptr) ? nullptr : slot->registration;
+            }
+
+            // A registration bound to the key itself wins over one derived
+            // from the canonical registration. Registrations without variants
+            // are returned whatever their type, resolving them then reports
+            // the mismatch.
+            const Registration* find(const ServiceQuery& query) const
+            {
+                auto* registration = find(query.key);
+                if (registration != nullptr && !registration->hasVariants())
+                    return registration;
+
+                if (registration == nullptr && query.canonicalType != query.key.type)
+                    registration = find(query.canonicalKey());
+
+                if (registration == nullptr || !registration->hasVariants())
+                    return nullptr;
+                return registration->variant(query.type);
+            }
+
+            // A later bind overrides an earlier one, so the keys of the forms
+            // the registration derives are erased. Otherwise a form bound
+            // under its own key earlier would still win in find().
+            void insert_or_assign(const ServiceKey& key, const Registration& registration)
+            {
+                for (auto type : registration.variantTypes())
+                    if (type != key.type)
+                        erase(ServiceKey { type, key.name });
+
+                assign(key, registration);
+            }
+
+            // The registration itself stays allocated until the table is
+            // destroyed, the table may have been published with it.
+            bool erase(const ServiceKey& key)
+            {
+                auto* slot = probe(key, hash(key), [] (size_t) {});
+                if (slot == nullptr)
+                    return false;
+
+                m_control[static_cast<size_t>(slot - m_slots.data())] = ErasedSlot;
+                m_size--;
+                m_erased++;
+                return true;
+            }
+
+            template <typename TVisitor>
+            void forEach(TVisitor&& visitor) const
+            {
+                for (size_t i = 0; i < m_control.size(); i++)
+                    if (isFull(m_control[i]))
+                        visitor(m_slots[i].key, *m_slots[i].registration);
+            }
+
+            size_t size() const
+            {
+                return m_size;
+            }
+
+            bool empty() const
+            {
+                return m_size == 0;
+            }
+    };
+}
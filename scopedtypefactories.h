@@ -1,126 +1,372 @@
 #pragma once
 
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstdint>
 #include <functional>
+#include <iterator>
 #include <memory>
+#include <mutex>
+#include <shared_mutex>
+#include <thread>
 #include <type_traits>
+#include <unordered_map>
 #include <utility>
+#include <vector>
 
+#include "cdif.h"
 #include "type_traits.h"
 
 namespace cdif
 {
+    template <Scope TScope, typename T>
+    class ScopedStorage;
+
     namespace detail {
-        template <
-            typename T,
-            typename TBase = typename get_base_type<T>::type,
-            typename TFactory = std::function<TBase (const Container&)>>
-        TBase& createSingleton(const TFactory& factory, const Container& ctx) 
+        // Owns a container's singletons in the order they finished building.
+        // A singleton is built after the singletons it depends on, so
+        // releasing them in reverse destroys each one before its
+        // dependencies.
+        class SingletonInstances
         {
-            static TBase instance = factory(ctx);
-            return instance;
-        }
+            private:
+                std::mutex m_mutex;
+                std::vector<std::shared_ptr<void>> m_instances;
 
-        template <
-            typename T,
-            typename ... TArgs,
-            typename TBase = typename get_base_type<T>::type,
-            typename TFactory = std::function<TBase (TArgs...)>>
-        TBase& createSingletonFactory(const TFactory& factory, TArgs&&... args)
-        {
-            static TBase instance = factory(std::forward<TArgs>(args)...);
-            return instance;
-        }
+            public:
+                SingletonInstances() : m_mutex(), m_instances() {}
 
-        template <
-            typename T,
-            typename TBase = typename get_base_type<T>::type,
-            typename TFactory = std::function<TBase (const Container&)>>
-        TBase& createThreadLocal(const TFactory& factory, const Container& ctx) 
-        {
-            thread_local TBase instance = factory(ctx);
-            return instance;
-        }
+                ~SingletonInstances()
+                {
+                    releaseAll();
+                }
+
+                SingletonInstances(const SingletonInstances&) = delete;
+                SingletonInstances& operator=(const SingletonInstances&) = delete;
+
+                void add(std::shared_ptr<void> instance)
+                {
+                    std::lock_guard<std::mutex> lock(m_mutex);
+                    m_instances.push_back(std::move(instance));
+                }
 
-        template <
-            typename T,
-            typename ... TArgs,
-            typename TBase = typename get_base_type<T>::type,
-            typename TFactory = std::function<TBase (TArgs...)>>
-        TBase& createThreadLocalFactory(const TFactory& factory, TArgs&&... args)
+                void releaseAll()
+                {
+                    auto released = std::vector<std::shared_ptr<void>>();
+                    {
+                        std::lock_guard<std::mutex> lock(m_mutex);
+                        released.swap(m_instances);
+                    }
+
+                    while (!released.empty())
+                        released.pop_back();
+                }
+        };
+    }
+
+    // Owned by the registrations of a single bind(), so every container and
+    // every named registration gets its own instance. After the first call
+    // an instance is returned with a single acquire load. The instance
+    // itself is owned by the container's SingletonInstances, a
+    // std::shared_ptr to it shares that ownership, so it keeps the instance
+    // alive after the container is gone.
+    template <typename T>
+    class ScopedStorage<Scope::Singleton, T>
+    {
+        private:
+            std::atomic<T*> m_instance;
+            std::once_flag m_initialized;
+            std::weak_ptr<T> m_owner;
+            std::shared_ptr<detail::SingletonInstances> m_instances;
+
+        public:
+            ScopedStorage(std::shared_ptr<detail::SingletonInstances> instances = std::make_shared<detail::SingletonInstances>())
+                : m_instance(nullptr), m_initialized(), m_owner(), m_instances(std::move(instances)) {};
+
+            ScopedStorage(const ScopedStorage&) = delete;
+            ScopedStorage& operator=(const ScopedStorage&) = delete;
+
+            template <typename TFactory, typename ... TArgs>
+            T& get(const TFactory& factory, TArgs&&... args)
+            {
+                auto* instance = m_instance.load(std::memory_order_acquire);
+                if (instance != nullptr)
+                    return *instance;
+
+                std::call_once(m_initialized, [&] ()
+                    {
+                        auto owner = std::shared_ptr<T>(new T(factory(std::forward<TArgs>(args)...)));
+                        m_owner = owner;
+                        m_instances->add(owner);
+                        m_instance.store(owner.get(), std::memory_order_release);
+                    });
+                return *m_instance.load(std::memory_order_acquire);
+            }
+
+            // The owner is only written before the instance is published.
+            template <typename TFactory, typename ... TArgs>
+            std::shared_ptr<T> getShared(const TFactory& factory, TArgs&&... args)
+            {
+                get(factory, std::forward<TArgs>(args)...);
+                return m_owner.lock();
+            }
+    };
+
+    // Per-thread instances that can be released before their thread exits.
+    class ThreadInstanceStorage : public std::enable_shared_from_this<ThreadInstanceStorage>
+    {
+        public:
+            virtual ~ThreadInstanceStorage() = default;
+
+            virtual void release(std::thread::id thread) = 0;
+            virtual void releaseAll() = 0;
+            virtual size_t threadCount() const = 0;
+    };
+
+    namespace detail {
+        inline uint64_t nextThreadInstanceStorageId()
         {
-            thread_local TBase instance = factory(std::forward<TArgs>(args)...);
-            return instance;
+            static std::atomic<uint64_t> nextId(1);
+            return nextId.fetch_add(1, std::memory_order_relaxed);
         }
 
-        template <typename T,
-            typename TBase = typename get_base_type<T>::type,
-            typename TFactory = std::function<TBase (const Container&)>,
-            typename TScopedFactory = std::function<TBase& (const TFactory&, const Container&)>>
-        T createScoped(const TFactory& factory, const Container& ctx, const TScopedFactory& scopedFactory)
+        // Releases a thread's instances from every storage it built one in
+        // when the thread exits, so instances never outlive their thread.
+        // Storages are tracked once per thread by id, a storage rebuilding
+        // an instance after a release is already tracked.
+        class ThreadExitCleanup
         {
-            static_assert(is_singleton_type<T>,
-                "Requested type is not compatible with scope (must be one of T*, T&, T&&, std::shared_ptr<T>)");
-            auto& instance = scopedFactory(factory, ctx);
+            private:
+                std::unordered_map<uint64_t, std::weak_ptr<ThreadInstanceStorage>> m_storages;
+                size_t m_pruneAt;
 
-            if constexpr (std::is_pointer_v<T>)
-                return &instance;
-            else if constexpr (cdif::is_shared_ptr<T>)
-                return std::shared_ptr<TBase>(&instance, [] (auto*) {});
-            else
-                return instance;
-        }
+                void pruneExpired()
+                {
+                    for (auto it = m_storages.begin(); it != m_storages.end(); )
+                        it = it->second.expired() ? m_storages.erase(it) : std::next(it);
+                }
+
+            public:
+                ThreadExitCleanup() : m_storages(), m_pruneAt(16) {}
+
+                ~ThreadExitCleanup()
+                {
+                    auto thread = std::this_thread::get_id();
+                    for (auto& [id, weakStorage] : m_storages)
+                        if (auto storage = weakStorage.lock())
+                            storage->release(thread);
+                }
+
+                ThreadExitCleanup(const ThreadExitCleanup&) = delete;
+                ThreadExitCleanup& operator=(const ThreadExitCleanup&) = delete;
+
+                void track(uint64_t id, std::weak_ptr<ThreadInstanceStorage> storage)
+                {
+                    if (!m_storages.emplace(id, std::move(storage)).second)
+                        return;
+
+                    if (m_storages.size() >= m_pruneAt) {
+                        pruneExpired();
+                        m_pruneAt = std::max<size_t>(16, m_storages.size() * 2);
+                    }
+                }
+
+                size_t size() const
+                {
+                    return m_storages.size();
+                }
+
+                static ThreadExitCleanup& forThisThread()
+                {
+                    thread_local ThreadExitCleanup cleanup;
+                    return cleanup;
+                }
+        };
+    }
+
+    // Owned by the registrations of a single bind(), so every container and
+    // every named registration gets its own instances. Each thread caches
+    // the instances it resolved last for the few storages of T it used
+    // most recently, keyed by storage id, so alternating between two
+    // registrations of T still hits. Releasing any thread's instances
+    // invalidates those caches through the generation counter. A
+    // std::shared_ptr to an instance is a copy of its owning pointer, so it
+    // keeps the instance alive after the instance is released.
+    //
+    // Instances must only be released once their thread has stopped using
+    // them.
+    template <typename T>
+    class ScopedStorage<Scope::PerThread, T> : public ThreadInstanceStorage
+    {
+        private:
+            struct CachedInstance
+            {
+                uint64_t storage;
+                uint64_t generation;
+                const std::shared_ptr<T>* owner;
+            };
+
+            static constexpr size_t CachedStorages = 4;
+
+            // Storage ids start at 1, so empty entries never match.
+            struct InstanceCache
+            {
+                std::array<CachedInstance, CachedStorages> entries;
+                size_t next;
+            };
+
+            const uint64_t m_id;
+            std::atomic<uint64_t> m_generation;
+            std::unordered_map<std::thread::id, std::shared_ptr<T>> m_instances;
+            mutable std::shared_mutex m_mutex;
+
+            static InstanceCache& instanceCache()
+            {
+                thread_local InstanceCache cache {};
+                return cache;
+            }
+
+            // Map nodes do not move, so the owner stays where it is until
+            // its thread's instance is released.
+            const std::shared_ptr<T>* find(std::thread::id thread) const
+            {
+                std::shared_lock<std::shared_mutex> lock(m_mutex);
+                auto it = m_instances.find(thread);
+                return (it == m_instances.end()) ? nullptr : &it->second;
+            }
+
+            const std::shared_ptr<T>* insert(std::thread::id thread, std::shared_ptr<T> instance)
+            {
+                std::unique_lock<std::shared_mutex> lock(m_mutex);
+                return &(m_instances[thread] = std::move(instance));
+            }
+
+            template <typename TFactory, typename ... TArgs>
+            const std::shared_ptr<T>& owner(const TFactory& factory, TArgs&&... args)
+            {
+                if (detail::ResolvingForOtherThread::isActive())
+                    throw detail::PerThreadInstanceRequested();
+
+                auto& cache = instanceCache();
+                auto generation = m_generation.load(std::memory_order_acquire);
+                auto* cached = static_cast<CachedInstance*>(nullptr);
+                for (auto& entry : cache.entries)
+                    if (entry.storage == m_id)
+                        cached = &entry;
+
+                if (cached != nullptr && cached->generation == generation)
+                    return *cached->owner;
+
+                auto thread = std::this_thread::get_id();
+                auto* owner = find(thread);
+                if (owner == nullptr) {
+                    owner = insert(thread, std::shared_ptr<T>(new T(factory(std::forward<TArgs>(args)...))));
+                    detail::ThreadExitCleanup::forThisThread().track(m_id, weak_from_this());
+                }
+
+                if (cached == nullptr) {
+                    cached = &cache.entries[cache.next];
+                    cache.next = (cache.next + 1) % CachedStorages;
+                }
+
+                *cached = CachedInstance { m_id, generation, owner };
+                return *owner;
+            }
+
+        public:
+            ScopedStorage()
+                : m_id(detail::nextThreadInstanceStorageId()),
+                m_generation(0),
+                m_instances(),
+                m_mutex() {};
+
+            ScopedStorage(const ScopedStorage&) = delete;
+            ScopedStorage& operator=(const ScopedStorage&) = delete;
+
+            template <typename TFactory, typename ... TArgs>
+            T& get(const TFactory& factory, TArgs&&... args)
+            {
+                return *owner(factory, std::forward<TArgs>(args)...);
+            }
+
+            template <typename TFactory, typename ... TArgs>
+            std::shared_ptr<T> getShared(const TFactory& factory, TArgs&&... args)
+            {
+                return owner(factory, std::forward<TArgs>(args)...);
+            }
 
+            void release(std::thread::id thread) override
+            {
+                auto released = std::shared_ptr<T>();
+                {
+                    std::unique_lock<std::shared_mutex> lock(m_mutex);
+                    auto it = m_instances.find(thread);
+                    if (it == m_instances.end())
+                        return;
+
+                    m_generation.fetch_add(1, std::memory_order_acq_rel);
+                    released = std::move(it->second);
+                    m_instances.erase(it);
+                }
+            }
+
+            void releaseAll() override
+            {
+                auto released = std::unordered_map<std::thread::id, std::shared_ptr<T>>();
+                {
+                    std::unique_lock<std::shared_mutex> lock(m_mutex);
+                    m_generation.fetch_add(1, std::memory_order_acq_rel);
+                    released.swap(m_instances);
+                }
+            }
+
+            size_t threadCount() const override
+            {
+                std::shared_lock<std::shared_mutex> lock(m_mutex);
+                return m_instances.size();
+            }
+    };
+
+    namespace detail {
         template <typename T,
-            typename ... TArgs,
-            typename TBase = typename get_base_type<T>::type,
-            typename TFactory = std::function<TBase (TArgs...)>,
-            typename TScopedFactory = std::function<TBase& (const TFactory&, TArgs...)>>
-        T createScopedFactory(const TFactory& factory, const TScopedFactory& scopedFactory, TArgs&&... args)
+            typename TBase = typename get_base_type<T>::type>
+        T fromScopedInstance(TBase& instance)
         {
             static_assert(is_singleton_type<T>,
                 "Requested type is not compatible with scope (must be one of T*, T&, T&&, std::shared_ptr<T>)");
-            auto& instance = scopedFactory(factory, std::forward<TArgs>(args)...);
+            static_assert(!cdif::is_shared_ptr<T>,
+                "A std::shared_ptr to a scoped instance must copy its owning pointer");
 
             if constexpr (std::is_pointer_v<T>)
                 return &instance;
-            else if constexpr (cdif::is_shared_ptr<T>)
-                return std::shared_ptr<TBase>(&instance, [] (auto*) {});
             else
                 return instance;
         }
     }
 
     template <typename T,
+        Scope TScope,
         typename TBase = typename get_base_type<T>::type,
         typename TFactory = std::function<TBase (const Container&)>>
-    T createSingleton(const TFactory& factory, const Container& ctx) 
-    {
-        return detail::createScoped<T>(factory, ctx, detail::createSingleton<T>); 
-    }
-
-    template <typename T,
-        typename TBase = typename get_base_type<T>::type,
-        typename TFactory = std::function<TBase (const Container&)>>
-    T createThreadLocal(const TFactory& factory, const Container& ctx)
-    {
-        return detail::createScoped<T>(factory, ctx, detail::createThreadLocal<T>);
-    }
-
-    template <typename T,
-        typename ... TArgs,
-        typename TBase = typename get_base_type<T>::type,
-        typename TFactory = std::function<TBase (TArgs...)>>
-    T createSingletonFactory(const TFactory& factory, TArgs&&... args)
+    T createScoped(const TFactory& factory, const Container& ctx, ScopedStorage<TScope, TBase>& storage)
     {
-        return detail::createScopedFactory<T>(factory, detail::createSingletonFactory<T, TArgs...>, std::forward<TArgs>(args)...);
+        if constexpr (cdif::is_shared_ptr<T>)
+            return storage.getShared(factory, ctx);
+        else
+            return detail::fromScopedInstance<T>(storage.get(factory, ctx));
     }
 
     template <typename T,
+        Scope TScope,
         typename ... TArgs,
         typename TBase = typename get_base_type<T>::type,
         typename TFactory = std::function<TBase (TArgs...)>>
-    T createThreadLocalFactory(const TFactory& factory, TArgs&&... args)
+    T createScopedFactory(const TFactory& factory, ScopedStorage<TScope, TBase>& storage, TArgs&&... args)
     {
-        return detail::createScopedFactory<T>(factory, detail::createThreadLocalFactory<T, TArgs...>, std::forward<TArgs>(args)...);
+        if constexpr (cdif::is_shared_ptr<T>)
+            return storage.getShared(factory, std::forward<TArgs>(args)...);
+        else
+            return detail::fromScopedInstance<T>(storage.get(factory, std::forward<TArgs>(args)...));
     }
 }
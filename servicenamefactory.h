@@ -1,13 +1,134 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <functional>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
 #include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "type_traits.h"
 
 namespace cdif {
+    struct ServiceKey
+    {
+        TypeKey type;
+        size_t name;
+
+        bool operator==(const ServiceKey& other) const
+        {
+            return type == other.type && name == other.name;
+        }
+
+        bool operator!=(const ServiceKey& other) const
+        {
+            return !(*this == other);
+        }
+
+        bool operator<(const ServiceKey& other) const
+        {
+            if (type != other.type)
+                return std::less<TypeKey>()(type, other.type);
+            return name < other.name;
+        }
+    };
+
+    // Asks for the registration resolving T under a key. When nothing is bound
+    // to the key itself, T is derived from the registration bound under its
+    // canonical type and the same name, see canonical_service.
+    struct ServiceQuery
+    {
+        ServiceKey key;
+        TypeKey type;
+        TypeKey canonicalType;
+
+        template <typename T>
+        static ServiceQuery of(const ServiceKey& key)
+        {
+            return { key, type_key<T>, type_key<canonical_service_t<T>> };
+        }
+
+        ServiceKey canonicalKey() const
+        {
+            return { canonicalType, key.name };
+        }
+
+        bool operator<(const ServiceQuery& other) const
+        {
+            if (key != other.key)
+                return key < other.key;
+            return std::less<TypeKey>()(type, other.type);
+        }
+    };
+
+    // Names are interned once and never removed. publish() snapshots them so
+    // that find() reads the snapshot without taking the lock, snapshots are
+    // kept until the factory is destroyed since readers may still hold them.
     class ServiceNameFactory {
+        private:
+            using Names = std::unordered_map<std::string, size_t>;
+
+            mutable std::shared_mutex m_mutex;
+            Names m_names;
+            std::vector<std::unique_ptr<const Names>> m_snapshots;
+            std::atomic<const Names*> m_published;
+
         public:
+            static constexpr size_t Unnamed = 0;
+            static constexpr size_t UnknownName = std::numeric_limits<size_t>::max();
+
+            ServiceNameFactory() : m_names(Names()), m_snapshots(), m_published(nullptr) {};
+
             template <typename TService>
-            const std::string create(const std::string& name) const
+            constexpr ServiceKey create() const
             {
-                auto typeName = typeid(TService).name();
-                return typeName + name;
+                return { type_key<TService>, Unnamed };
+            }
+
+            template <typename TService>
+            ServiceKey create(const std::string& name)
+            {
+                if (name.empty())
+                    return create<TService>();
+
+                std::unique_lock<std::shared_mutex> lock(m_mutex);
+                auto id = m_names.emplace(name, m_names.size() + 1).first->second;
+                return { type_key<TService>, id };
+            }
+
+            template <typename TService>
+            ServiceKey find(const std::string& name) const
+            {
+                if (name.empty())
+                    return create<TService>();
+
+                auto* published = m_published.load(std::memory_order_acquire);
+                if (published != nullptr) {
+                    auto it = published->find(name);
+                    if (it != published->end())
+                        return { type_key<TService>, it->second };
+                }
+
+                std::shared_lock<std::shared_mutex> lock(m_mutex);
+                auto it = m_names.find(name);
+                return { type_key<TService>, (it == m_names.end()) ? UnknownName : it->second };
+            }
+
+            // Names created since the last call are found under the lock
+            // until the next one.
+            void publish()
+            {
+                std::unique_lock<std::shared_mutex> lock(m_mutex);
+                auto* published = m_published.load(std::memory_order_relaxed);
+                if (published != nullptr && published->size() == m_names.size())
+                    return;
+
+                m_snapshots.push_back(std::make_unique<const Names>(m_names));
+                m_published.store(m_snapshots.back().get(), std::memory_order_release);
             }
     };
 }
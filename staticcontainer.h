@@ -0,0 +1,402 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <list>
+#include <memory>
+#include <optional>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "cdif.h"
+
+namespace cdif {
+    // Marks a dependency of a static binding as resolved from the binding
+    // named TName, e.g. Bind<Foo, Named<std::shared_ptr<IBar>, Primary>>.
+    template <typename T, typename TName>
+    struct Named;
+
+    namespace detail {
+        struct Unnamed;
+
+        template <typename T>
+        struct static_dependency
+        {
+            using type = T;
+            using name_type = Unnamed;
+        };
+
+        template <typename T, typename TName>
+        struct static_dependency<Named<T, TName>>
+        {
+            using type = T;
+            using name_type = TName;
+        };
+
+        template <typename T>
+        struct function_traits;
+
+        template <typename TReturn, typename ... TArgs>
+        struct function_traits<TReturn (*)(TArgs...)>
+        {
+            using return_type = TReturn;
+
+            template <template <typename...> typename TBinding>
+            using apply = TBinding<TArgs...>;
+        };
+
+        // The forms a PerDependency binding of TService resolves as, where
+        // TInterface is TService or one of its bases.
+        template <typename T, typename TService, typename TInterface, typename TCreate>
+        T createStatic(TCreate&& create)
+        {
+            if constexpr (std::is_same_v<T, TInterface>) {
+                static_assert(std::is_same_v<TInterface, TService>, "An interface can only be resolved as a pointer");
+                return create([] (auto&& ... args) { return TService(std::forward<decltype(args)>(args)...); });
+            } else if constexpr (std::is_same_v<T, TInterface*>) {
+                return create([] (auto&& ... args) -> TInterface* { return new TService(std::forward<decltype(args)>(args)...); });
+            } else if constexpr (std::is_same_v<T, std::shared_ptr<TInterface>>) {
+                return create([] (auto&& ... args) -> T { return std::make_shared<TService>(std::forward<decltype(args)>(args)...); });
+            } else if constexpr (std::is_same_v<T, std::unique_ptr<TInterface>>) {
+                return create([] (auto&& ... args) -> T { return std::make_unique<TService>(std::forward<decltype(args)>(args)...); });
+            } else {
+                static_assert(!std::is_same_v<T, T>,
+                    "Requested type is not compatible with scope (must be one of T, T*, std::shared_ptr<T>, std::unique_ptr<T>)");
+            }
+        }
+
+        template <typename TBinding, typename TService, typename TInterface, Scope TScope, typename TName, typename ... TDeps>
+        struct StaticBindingOf
+        {
+            static_assert(TScope == Scope::PerDependency || TScope == Scope::Singleton,
+                "StaticContainer bindings must be Scope::PerDependency or Scope::Singleton");
+
+            using service_type = TService;
+            using name_type = TName;
+            using dependencies = std::tuple<TDeps...>;
+
+            static constexpr Scope scope = TScope;
+
+            template <typename TCanonical, typename TRequestedName>
+            static constexpr bool provides = std::is_same_v<TRequestedName, TName> &&
+                (std::is_same_v<TCanonical, TService> || std::is_same_v<TCanonical, TInterface>);
+
+            template <typename T, typename TResolve>
+            static T create(TResolve&& resolve)
+            {
+                using TRequested = canonical_service_t<T>;
+                return createStatic<T, TService, TRequested>([&resolve] (auto&& construct)
+                    {
+                        return TBinding::build(construct, resolve);
+                    });
+            }
+
+            template <typename TSlot, typename TResolve>
+            static void emplace(TSlot& slot, TResolve&& resolve)
+            {
+                TBinding::build([&slot] (auto&& ... args) { slot.emplace(std::forward<decltype(args)>(args)...); }, resolve);
+            }
+        };
+
+        template <typename TService, typename TInterface, Scope TScope, typename TName, typename ... TDeps>
+        struct StaticTypeBinding
+            : StaticBindingOf<StaticTypeBinding<TService, TInterface, TScope, TName, TDeps...>, TService, TInterface, TScope, TName, TDeps...>
+        {
+            static_assert(has_constructor_with_args<TService, typename static_dependency<TDeps>::type...>::value,
+                "Cannot find constructor for service matching provided arguments");
+            static_assert(std::is_same_v<TInterface, TService> || std::is_base_of_v<TInterface, TService>,
+                "TService must derive TInterface");
+
+            template <typename TNewInterface>
+            using as = StaticTypeBinding<TService, TNewInterface, TScope, TName, TDeps...>;
+
+            template <Scope TNewScope>
+            using in = StaticTypeBinding<TService, TInterface, TNewScope, TName, TDeps...>;
+
+            template <typename TNewName>
+            using named = StaticTypeBinding<TService, TInterface, TScope, TNewName, TDeps...>;
+
+            template <typename TConstruct, typename TResolve>
+            static decltype(auto) build(TConstruct&& construct, TResolve&& resolve)
+            {
+                return construct(resolve(type_identity<TDeps>())...);
+            }
+        };
+
+        template <auto Factory, typename TReturn, typename TInterface, Scope TScope, typename TName, typename ... TDeps>
+        struct StaticFactoryBinding
+            : StaticBindingOf<StaticFactoryBinding<Factory, TReturn, TInterface, TScope, TName, TDeps...>, TReturn, TInterface, TScope, TName, TDeps...>
+        {
+            static_assert(std::is_same_v<TInterface, TReturn> || std::is_base_of_v<TInterface, TReturn>,
+                "TReturn must derive TInterface");
+
+            template <typename TNewInterface>
+            using as = StaticFactoryBinding<Factory, TReturn, TNewInterface, TScope, TName, TDeps...>;
+
+            template <Scope TNewScope>
+            using in = StaticFactoryBinding<Factory, TReturn, TInterface, TNewScope, TName, TDeps...>;
+
+            template <typename TNewName>
+            using named = StaticFactoryBinding<Factory, TReturn, TInterface, TScope, TNewName, TDeps...>;
+
+            template <typename TConstruct, typename TResolve>
+            static decltype(auto) build(TConstruct&& construct, TResolve&& resolve)
+            {
+                return construct(Factory(resolve(type_identity<TDeps>())...));
+            }
+        };
+
+        template <auto Factory>
+        struct StaticFactoryBindingFor
+        {
+            using return_type = typename function_traits<decltype(Factory)>::return_type;
+
+            template <typename ... TArgs>
+            using binding = StaticFactoryBinding<Factory, return_type, return_type, Scope::PerDependency, Unnamed, TArgs...>;
+
+            using type = typename function_traits<decltype(Factory)>::template apply<binding>;
+        };
+
+        // A PerDependency list resolves as std::vector, std::list or
+        // std::array of TService, a singleton list as std::vector.
+        template <typename TService, Scope TScope, typename TName, typename ... TImplementations>
+        struct StaticListBinding
+        {
+            static_assert(TScope == Scope::PerDependency || TScope == Scope::Singleton,
+                "StaticContainer bindings must be Scope::PerDependency or Scope::Singleton");
+
+            using service_type = std::vector<TService>;
+            using name_type = TName;
+            using dependencies = std::tuple<TImplementations...>;
+
+            static constexpr Scope scope = TScope;
+
+            template <typename TCanonical, typename TRequestedName>
+            static constexpr bool provides = std::is_same_v<TRequestedName, TName> &&
+                (std::is_same_v<TCanonical, std::vector<TService>> ||
+                    (TScope == Scope::PerDependency &&
+                        (std::is_same_v<TCanonical, std::list<TService>> ||
+                            std::is_same_v<TCanonical, std::array<TService, sizeof...(TImplementations)>>)));
+
+            template <Scope TNewScope>
+            using in = StaticListBinding<TService, TNewScope, TName, TImplementations...>;
+
+            template <typename TNewName>
+            using named = StaticListBinding<TService, TScope, TNewName, TImplementations...>;
+
+            template <typename T, typename TResolve>
+            static T create(TResolve&& resolve)
+            {
+                static_assert(!std::is_reference_v<T> && !std::is_pointer_v<T>,
+                    "A PerDependency list can only be resolved by value");
+
+                if constexpr (std::is_same_v<T, std::vector<TService>>) {
+                    auto list = T();
+                    list.reserve(sizeof...(TImplementations));
+                    ( list.push_back(static_cast<TService>(resolve(type_identity<TImplementations>()))), ... );
+                    return list;
+                } else {
+                    return T { static_cast<TService>(resolve(type_identity<TImplementations>()))... };
+                }
+            }
+
+            template <typename TSlot, typename TResolve>
+            static void emplace(TSlot& slot, TResolve&& resolve)
+            {
+                slot.emplace(create<std::vector<TService>>(resolve));
+            }
+        };
+
+        template <typename TBinding, bool = (TBinding::scope == Scope::Singleton)>
+        struct StaticSingletonSlot
+        {
+        };
+
+        template <typename TBinding>
+        struct StaticSingletonSlot<TBinding, true>
+        {
+            std::optional<typename TBinding::service_type> instance;
+        };
+
+        inline constexpr size_t NoBinding = static_cast<size_t>(-1);
+    }
+
+    // The bindings of a StaticContainer, mirroring bind<TService, TDeps...>(),
+    // bind(factory) and bindList<TService, TImplementations...>().
+    template <typename TService, typename ... TDeps>
+    using Bind = detail::StaticTypeBinding<TService, TService, Scope::PerDependency, detail::Unnamed, TDeps...>;
+
+    // The factory's parameters are its dependencies.
+    template <auto Factory>
+    using BindFactory = typename detail::StaticFactoryBindingFor<Factory>::type;
+
+    template <typename TService, typename ... TImplementations>
+    using BindList = detail::StaticListBinding<TService, Scope::PerDependency, detail::Unnamed, TImplementations...>;
+
+    // Matches every dependency of every binding to the binding resolving it.
+    template <typename ... TBindings>
+    struct StaticBindings
+    {
+        template <typename T, typename TName = detail::Unnamed>
+        static constexpr size_t indexOf()
+        {
+            constexpr std::array<bool, sizeof...(TBindings)> matches = {
+                { TBindings::template provides<canonical_service_t<T>, TName>... } };
+
+            auto index = detail::NoBinding;
+            for (size_t i = 0; i < matches.size(); i++) {
+                if (!matches[i])
+                    continue;
+                if (index != detail::NoBinding)
+                    return detail::NoBinding - 1;
+                index = i;
+            }
+            return index;
+        }
+
+        template <typename TDependency>
+        static constexpr size_t dependencyIndexOf()
+        {
+            using Dependency = detail::static_dependency<TDependency>;
+            return indexOf<typename Dependency::type, typename Dependency::name_type>();
+        }
+
+        template <typename T, typename TName = detail::Unnamed>
+        static constexpr bool is_bound = indexOf<T, TName>() < sizeof...(TBindings);
+
+        template <size_t Index, typename ... TDeps>
+        struct Node
+        {
+            using service_type = std::integral_constant<size_t, Index>;
+
+            template <typename T>
+            static constexpr bool depends_on = ((dependencyIndexOf<TDeps>() == T::value) || ...);
+        };
+
+        template <size_t Index, typename TBinding, typename TDependencies = typename TBinding::dependencies>
+        struct NodeFor;
+
+        template <size_t Index, typename TBinding, typename ... TDeps>
+        struct NodeFor<Index, TBinding, std::tuple<TDeps...>>
+        {
+            using type = Node<Index, TDeps...>;
+            static constexpr bool is_complete = ((dependencyIndexOf<TDeps>() < sizeof...(TBindings)) && ...);
+        };
+
+        template <typename Indices = std::make_index_sequence<sizeof...(TBindings)>>
+        struct Analysis;
+
+        template <size_t ... Indices>
+        struct Analysis<std::index_sequence<Indices...>>
+        {
+            static constexpr bool is_complete = (NodeFor<Indices, TBindings>::is_complete && ...);
+            static constexpr bool is_acyclic =
+                !detail::DependencyGraphAnalysis<typename NodeFor<Indices, TBindings>::type...>::hasCycle();
+        };
+
+        // Every dependency is satisfied by exactly one binding.
+        static constexpr bool is_complete = Analysis<>::is_complete;
+        static constexpr bool is_acyclic = Analysis<>::is_acyclic;
+    };
+
+    // A container whose whole object graph is given by its bindings. Each
+    // resolve is a direct call to the constructor or factory, with the
+    // dependencies resolved the same way. Singletons are members of the
+    // container and are all built when it is constructed, resolving them
+    // afterwards only reads the member, so a StaticContainer can be shared
+    // between threads without locking. A std::shared_ptr to a singleton does
+    // not own it: it shares a handle owned by the container and must not
+    // outlive the container, like a pointer or reference would.
+    //
+    // A type requested without exactly one binding, a dependency without
+    // one, or a cycle between bindings fails to compile.
+    template <typename ... TBindings>
+    class StaticContainer
+    {
+        private:
+            using Bindings = StaticBindings<TBindings...>;
+
+            static_assert(Bindings::is_complete, "A dependency of a static binding is not bound, or bound more than once");
+            static_assert(Bindings::is_acyclic, "Circular dependency detected between static bindings");
+
+            mutable std::tuple<detail::StaticSingletonSlot<TBindings>...> m_singletons;
+            std::shared_ptr<const void> m_lifetime;
+
+            template <size_t Index>
+            using BindingAt = std::tuple_element_t<Index, std::tuple<TBindings...>>;
+
+            template <typename TDependency>
+            decltype(auto) resolveDependency() const
+            {
+                using Dependency = detail::static_dependency<TDependency>;
+                return resolve<typename Dependency::type, typename Dependency::name_type>();
+            }
+
+            auto resolver() const
+            {
+                return [this] (auto dependency) -> decltype(auto)
+                    {
+                        return resolveDependency<typename decltype(dependency)::type>();
+                    };
+            }
+
+            // Only builds the instance while the container is being
+            // constructed, by the time it is shared every singleton exists
+            // and the slots are only read.
+            template <size_t Index>
+            auto& singleton() const
+            {
+                auto& slot = std::get<Index>(m_singletons).instance;
+                if (!slot.has_value())
+                    BindingAt<Index>::emplace(slot, resolver());
+                return *slot;
+            }
+
+            template <size_t Index>
+            void buildSingleton()
+            {
+                if constexpr (BindingAt<Index>::scope == Scope::Singleton)
+                    singleton<Index>();
+            }
+
+            template <size_t ... Indices>
+            void buildSingletons(std::index_sequence<Indices...>)
+            {
+                ( buildSingleton<Indices>(), ... );
+            }
+
+        public:
+            StaticContainer() : m_singletons(), m_lifetime(std::make_shared<char>())
+            {
+                buildSingletons(std::make_index_sequence<sizeof...(TBindings)>());
+            }
+
+            StaticContainer(const StaticContainer&) = delete;
+            StaticContainer& operator=(const StaticContainer&) = delete;
+
+            template <typename TService, typename TName = detail::Unnamed>
+            static constexpr bool can_resolve = Bindings::template is_bound<TService, TName>;
+
+            template <typename TService, typename TName = detail::Unnamed>
+            TService resolve() const
+            {
+                constexpr auto index = Bindings::template indexOf<TService, TName>();
+                static_assert(index != detail::NoBinding, "Type not bound in StaticContainer");
+                static_assert(index < sizeof...(TBindings), "Type bound more than once in StaticContainer");
+
+                using Binding = BindingAt<index>;
+                if constexpr (Binding::scope == Scope::Singleton) {
+                    using TBase = canonical_service_t<TService>;
+                    auto& instance = static_cast<TBase&>(singleton<index>());
+                    if constexpr (is_shared_ptr<TService>)
+                        return TService(m_lifetime, &instance);
+                    else
+                        return detail::fromScopedInstance<TService>(instance);
+                } else {
+                    return Binding::template create<TService>(resolver());
+                }
+            }
+    };
+}
@@ -0,0 +1,352 @@
+#pragma once
+
+#include "cdif.h"
+
+#if defined(CDIF_COROUTINES)
+
+#include <atomic>
+#include <coroutine>
+#include <cstddef>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <variant>
+#include <vector>
+
+namespace cdif {
+    // A coroutine producing a T, or a reference when T is one. It does not
+    // start until it is awaited and it resumes its awaiter when it finishes,
+    // on whichever thread finished it.
+    template <typename T>
+    class Task
+    {
+        private:
+            typedef std::conditional_t<std::is_reference_v<T>, std::remove_reference_t<T>*, T> Stored;
+
+        public:
+            struct promise_type
+            {
+                std::variant<std::monostate, Stored, std::exception_ptr> result;
+                std::coroutine_handle<> continuation;
+
+                struct FinalAwaiter
+                {
+                    bool await_ready() const noexcept { return false; }
+
+                    std::coroutine_handle<> await_suspend(std::coroutine_handle<promise_type> handle) const noexcept
+                    {
+                        auto continuation = handle.promise().continuation;
+                        return continuation ? continuation : std::noop_coroutine();
+                    }
+
+                    void await_resume() const noexcept {}
+                };
+
+                Task get_return_object()
+                {
+                    return Task(std::coroutine_handle<promise_type>::from_promise(*this));
+                }
+
+                std::suspend_always initial_suspend() const noexcept { return {}; }
+                FinalAwaiter final_suspend() const noexcept { return {}; }
+
+                template <typename TValue>
+                void return_value(TValue&& value)
+                {
+                    if constexpr (std::is_reference_v<T>)
+                        result.template emplace<1>(&value);
+                    else
+                        result.template emplace<1>(std::forward<TValue>(value));
+                }
+
+                void unhandled_exception()
+                {
+                    result.template emplace<2>(std::current_exception());
+                }
+            };
+
+        private:
+            std::coroutine_handle<promise_type> m_handle;
+
+            explicit Task(std::coroutine_handle<promise_type> handle) : m_handle(handle) {}
+
+            // Starts the task and waits for it without taking its result.
+            struct ReadyAwaiter
+            {
+                std::coroutine_handle<promise_type> handle;
+
+                bool await_ready() const noexcept { return handle.done(); }
+
+                std::coroutine_handle<> await_suspend(std::coroutine_handle<> awaiting) const noexcept
+                {
+                    handle.promise().continuation = awaiting;
+                    return handle;
+                }
+
+                void await_resume() const noexcept {}
+            };
+
+            struct ResultAwaiter : ReadyAwaiter
+            {
+                T await_resume() const
+                {
+                    return Task::resultOf(this->handle);
+                }
+            };
+
+            static T resultOf(std::coroutine_handle<promise_type> handle)
+            {
+                auto& result = handle.promise().result;
+                if (result.index() == 2)
+                    std::rethrow_exception(std::get<2>(result));
+
+                if constexpr (std::is_reference_v<T>)
+                    return *std::get<1>(result);
+                else
+                    return std::move(std::get<1>(result));
+            }
+
+        public:
+            using value_type = T;
+
+            Task(Task&& other) noexcept : m_handle(std::exchange(other.m_handle, nullptr)) {}
+
+            Task& operator=(Task&& other) noexcept
+            {
+                if (this != &other) {
+                    if (m_handle)
+                        m_handle.destroy();
+                    m_handle = std::exchange(other.m_handle, nullptr);
+                }
+                return *this;
+            }
+
+            Task(const Task&) = delete;
+            Task& operator=(const Task&) = delete;
+
+            ~Task()
+            {
+                if (m_handle)
+                    m_handle.destroy();
+            }
+
+            ResultAwaiter operator co_await() const noexcept
+            {
+                return ResultAwaiter { { m_handle } };
+            }
+
+            // Awaits completion and leaves the result, or the exception, in
+            // the task for result().
+            ReadyAwaiter whenReady() const noexcept
+            {
+                return ReadyAwaiter { m_handle };
+            }
+
+            bool isReady() const
+            {
+                return m_handle && m_handle.done();
+            }
+
+            T result() const
+            {
+                return resultOf(m_handle);
+            }
+    };
+
+    namespace detail {
+        // Resumes the awaiting coroutine once every task it started has
+        // finished. The extra count belongs to the awaiting coroutine, so a
+        // task that finishes before it has suspended cannot resume it.
+        struct WhenAllCounter
+        {
+            std::atomic<size_t> remaining;
+            std::coroutine_handle<> awaiting;
+
+            void arrive()
+            {
+                if (remaining.fetch_sub(1, std::memory_order_acq_rel) == 1)
+                    awaiting.resume();
+            }
+        };
+
+        // A coroutine nothing awaits, it frees itself when it finishes.
+        struct Detached
+        {
+            struct promise_type
+            {
+                Detached get_return_object() const noexcept { return {}; }
+                std::suspend_never initial_suspend() const noexcept { return {}; }
+                std::suspend_never final_suspend() const noexcept { return {}; }
+                void return_void() const noexcept {}
+                void unhandled_exception() const noexcept { std::terminate(); }
+            };
+        };
+
+        template <typename T>
+        Detached arriveWhenReady(const Task<T>& task, WhenAllCounter& counter)
+        {
+            co_await task.whenReady();
+            counter.arrive();
+        }
+
+        // Starts every task before waiting for any of them, so tasks that
+        // suspend on I/O run concurrently even on one thread.
+        template <typename ... Ts>
+        struct WhenAllAwaiter
+        {
+            const std::tuple<Task<Ts>...>& tasks;
+            WhenAllCounter counter;
+
+            bool await_ready() const noexcept
+            {
+                return sizeof...(Ts) == 0;
+            }
+
+            bool await_suspend(std::coroutine_handle<> awaiting)
+            {
+                counter.remaining.store(sizeof...(Ts) + 1, std::memory_order_relaxed);
+                counter.awaiting = awaiting;
+                std::apply([this] (const auto& ... task) { ( arriveWhenReady(task, counter), ... ); }, tasks);
+                return counter.remaining.fetch_sub(1, std::memory_order_acq_rel) != 1;
+            }
+
+            void await_resume() const noexcept {}
+        };
+
+        template <typename ... Ts>
+        WhenAllAwaiter<Ts...> whenAllReady(const std::tuple<Task<Ts>...>& tasks)
+        {
+            return WhenAllAwaiter<Ts...> { tasks, {} };
+        }
+    }
+
+    // Builds an async singleton once. Callers that arrive while it is being
+    // built are resumed, on the building thread, once it is done. A failed
+    // build hands its exception to the callers waiting on it, the next
+    // caller builds again.
+    template <typename T>
+    class AsyncSingletonStorage
+    {
+        private:
+            std::mutex m_mutex;
+            bool m_building;
+            std::optional<T> m_instance;
+            std::exception_ptr m_error;
+            std::vector<std::coroutine_handle<>> m_waiting;
+
+            struct BuildAwaiter
+            {
+                AsyncSingletonStorage& storage;
+                bool build;
+
+                bool await_ready() noexcept
+                {
+                    std::lock_guard<std::mutex> lock(storage.m_mutex);
+                    if (storage.m_instance.has_value())
+                        return true;
+                    build = !storage.m_building;
+                    storage.m_building = true;
+                    return build;
+                }
+
+                bool await_suspend(std::coroutine_handle<> awaiting)
+                {
+                    std::lock_guard<std::mutex> lock(storage.m_mutex);
+                    if (!storage.m_building)
+                        return false;
+                    storage.m_waiting.push_back(awaiting);
+                    return true;
+                }
+
+                bool await_resume() const noexcept
+                {
+                    return build;
+                }
+            };
+
+            void finish(std::exception_ptr error)
+            {
+                auto waiting = std::vector<std::coroutine_handle<>>();
+                {
+                    std::lock_guard<std::mutex> lock(m_mutex);
+                    m_building = false;
+                    m_error = error;
+                    waiting.swap(m_waiting);
+                }
+
+                for (auto& awaiting : waiting)
+                    awaiting.resume();
+            }
+
+            T& instance()
+            {
+                std::lock_guard<std::mutex> lock(m_mutex);
+                if (!m_instance.has_value())
+                    std::rethrow_exception(m_error);
+                return *m_instance;
+            }
+
+        public:
+            AsyncSingletonStorage() : m_mutex(), m_building(false), m_instance(), m_error(), m_waiting() {}
+
+            AsyncSingletonStorage(const AsyncSingletonStorage&) = delete;
+            AsyncSingletonStorage& operator=(const AsyncSingletonStorage&) = delete;
+
+            template <typename TFactory>
+            static Task<T&> get(std::shared_ptr<AsyncSingletonStorage> storage, TFactory factory)
+            {
+                if (co_await BuildAwaiter { *storage, false }) {
+                    auto error = std::exception_ptr();
+                    try {
+                        auto instance = co_await factory();
+                        std::lock_guard<std::mutex> lock(storage->m_mutex);
+                        storage->m_instance.emplace(std::move(instance));
+                    } catch (...) {
+                        error = std::current_exception();
+                    }
+                    storage->finish(error);
+                }
+
+                co_return storage->instance();
+            }
+    };
+
+    template <typename TService>
+    Task<TService> Container::resolveNow(const Container* ctx, ServiceKey key)
+    {
+        co_return ctx->resolveKey<TService>(key);
+    }
+
+    template <typename TService>
+    Task<TService> Container::resolveCoFrom(const ServiceKey& key) const
+    {
+        {
+            auto epoch = EpochGuard();
+            auto* registration = m_registrar->findRegistration<Task<TService>>(
+                ServiceKey { type_key<Task<TService>>, key.name });
+            if (registration != nullptr)
+                return registration->template resolve<Task<TService>>(*this);
+        }
+
+        return resolveNow<TService>(this, key);
+    }
+
+    template <typename TService>
+    Task<TService> Container::resolveCo() const
+    {
+        return resolveCoFrom<TService>(m_serviceNameFactory->create<remove_cvref_t<TService>>());
+    }
+
+    template <typename TService>
+    Task<TService> Container::resolveCo(const std::string& name) const
+    {
+        return resolveCoFrom<TService>(m_serviceNameFactory->find<remove_cvref_t<TService>>(name));
+    }
+}
+
+#endif
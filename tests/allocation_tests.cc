@@ -0,0 +1,141 @@
+#include <list>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "allocationcounter.h"
+#include "cdif.h"
+#include "test_types.h"
+
+using allocationcounter::allocationsOf;
+
+// Pins the heap allocations of a warmed resolve of each kind in each scope.
+// Each count is taken after one resolve has built whatever is cached, so it
+// is the steady state cost. Lower a count when the hot path stops
+// allocating, a count going up is a regression.
+class AllocationTests : public ::testing::Test
+{
+    protected:
+        cdif::Container _subject;
+
+        template <cdif::Scope TScope>
+        void givenInterfaceIn()
+        {
+            _subject.bind<int>([] () { return 5; }).build();
+            _subject.bind<SimpleImplementation, int>().as<Interface>().in<TScope>().build();
+        }
+
+        template <typename TService>
+        size_t allocationsOfResolve()
+        {
+            _subject.resolve<TService>();
+            return allocationsOf([this] () { _subject.resolve<TService>(); });
+        }
+
+        template <typename TService>
+        size_t allocationsOfResolve(const std::string& name)
+        {
+            _subject.resolve<TService>(name);
+            return allocationsOf([this, &name] () { _subject.resolve<TService>(name); });
+        }
+};
+
+TEST_F(AllocationTests, AllocationsOf_GivenHeapAllocation_CountsIt)
+{
+    auto kept = std::unique_ptr<int>();
+
+    ASSERT_EQ(1u, allocationsOf([&kept] () { kept = std::make_unique<int>(1); }));
+}
+
+TEST_F(AllocationTests, Resolve_GivenPerDependency_AllocatesOnlyTheInstance)
+{
+    givenInterfaceIn<cdif::Scope::PerDependency>();
+
+    EXPECT_EQ(0u, allocationsOfResolve<SimpleImplementation>());
+    EXPECT_EQ(1u, allocationsOfResolve<std::shared_ptr<Interface>>());
+    EXPECT_EQ(1u, allocationsOfResolve<std::unique_ptr<Interface>>());
+}
+
+TEST_F(AllocationTests, Resolve_GivenSingleton_AllocatesNothing)
+{
+    givenInterfaceIn<cdif::Scope::Singleton>();
+
+    EXPECT_EQ(0u, allocationsOfResolve<Interface&>());
+    EXPECT_EQ(0u, allocationsOfResolve<Interface*>());
+    EXPECT_EQ(0u, allocationsOfResolve<std::shared_ptr<Interface>>());
+}
+
+TEST_F(AllocationTests, Resolve_GivenPerThread_AllocatesNothing)
+{
+    givenInterfaceIn<cdif::Scope::PerThread>();
+
+    EXPECT_EQ(0u, allocationsOfResolve<Interface&>());
+    EXPECT_EQ(0u, allocationsOfResolve<Interface*>());
+    EXPECT_EQ(0u, allocationsOfResolve<std::shared_ptr<Interface>>());
+}
+
+TEST_F(AllocationTests, Resolve_GivenCompiledSingleton_AllocatesNothing)
+{
+    givenInterfaceIn<cdif::Scope::Singleton>();
+    _subject.compile();
+
+    EXPECT_EQ(0u, allocationsOfResolve<Interface&>());
+    EXPECT_EQ(0u, allocationsOfResolve<std::shared_ptr<Interface>>());
+}
+
+TEST_F(AllocationTests, Resolve_GivenNamedSingleton_AllocatesNothingForReference)
+{
+    _subject.bind<int>([] () { return 5; }).build();
+    _subject.bind<SimpleImplementation, int>().in<cdif::Scope::Singleton>().named("named").build();
+
+    EXPECT_EQ(0u, allocationsOfResolve<SimpleImplementation&>("named"));
+}
+
+TEST_F(AllocationTests, Resolve_GivenPerScope_AllocatesNothingForReferenceWithinScope)
+{
+    givenInterfaceIn<cdif::Scope::PerScope>();
+    auto scope = _subject.beginScope();
+    scope.resolve<Interface&>();
+
+    EXPECT_EQ(0u, allocationsOf([&scope] () { scope.resolve<Interface&>(); }));
+}
+
+TEST_F(AllocationTests, Call_GivenSingletonProvider_AllocatesNothing)
+{
+    givenInterfaceIn<cdif::Scope::Singleton>();
+    auto provider = _subject.provider<Interface&>();
+    provider();
+
+    EXPECT_EQ(0u, allocationsOf([&provider] () { provider(); }));
+}
+
+TEST_F(AllocationTests, Get_GivenResolvedLazy_AllocatesNothing)
+{
+    givenInterfaceIn<cdif::Scope::Singleton>();
+    auto lazy = _subject.resolve<cdif::Lazy<Interface&>>();
+    lazy.get();
+
+    EXPECT_EQ(0u, allocationsOf([&lazy] () { lazy.get(); }));
+}
+
+TEST_F(AllocationTests, Resolve_GivenSingletonList_AllocatesNothingForReference)
+{
+    _subject.bind<int>([] () { return 5; }).build();
+    _subject.bind<SimpleImplementation, int>().build();
+    _subject.bindList<std::shared_ptr<Interface>, std::shared_ptr<SimpleImplementation>, std::shared_ptr<SimpleImplementation>>()
+        .in<cdif::Scope::Singleton>()
+        .build();
+
+    EXPECT_EQ(0u, allocationsOfResolve<std::vector<std::shared_ptr<Interface>>&>());
+}
+
+TEST_F(AllocationTests, Resolve_GivenPerDependencyList_AllocatesVectorAndElements)
+{
+    _subject.bind<int>([] () { return 5; }).build();
+    _subject.bind<SimpleImplementation, int>().build();
+    _subject.bindList<std::shared_ptr<Interface>, std::shared_ptr<SimpleImplementation>, std::shared_ptr<SimpleImplementation>>().build();
+
+    EXPECT_EQ(3u, allocationsOfResolve<std::vector<std::shared_ptr<Interface>>>());
+}
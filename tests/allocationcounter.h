@@ -0,0 +1,52 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdlib>
+#include <new>
+
+// Counts the heap allocations made by each thread by replacing the global
+// operator new and delete. A binary may only replace them once, so include
+// this from a single translation unit.
+namespace allocationcounter {
+    inline thread_local size_t allocations = 0;
+
+    inline void* allocate(size_t size)
+    {
+        allocations++;
+        if (auto* memory = std::malloc((size == 0) ? 1 : size))
+            return memory;
+        throw std::bad_alloc();
+    }
+
+    inline void* allocate(size_t size, std::align_val_t alignment)
+    {
+        allocations++;
+        auto align = static_cast<size_t>(alignment);
+        if (auto* memory = std::aligned_alloc(align, (size + align - 1) / align * align))
+            return memory;
+        throw std::bad_alloc();
+    }
+
+    // The allocations body makes on this thread.
+    template <typename TBody>
+    size_t allocationsOf(TBody&& body)
+    {
+        auto start = allocations;
+        body();
+        return allocations - start;
+    }
+}
+
+void* operator new(size_t size) { return allocationcounter::allocate(size); }
+void* operator new[](size_t size) { return allocationcounter::allocate(size); }
+void* operator new(size_t size, std::align_val_t alignment) { return allocationcounter::allocate(size, alignment); }
+void* operator new[](size_t size, std::align_val_t alignment) { return allocationcounter::allocate(size, alignment); }
+
+void operator delete(void* memory) noexcept { std::free(memory); }
+void operator delete[](void* memory) noexcept { std::free(memory); }
+void operator delete(void* memory, size_t) noexcept { std::free(memory); }
+void operator delete[](void* memory, size_t) noexcept { std::free(memory); }
+void operator delete(void* memory, std::align_val_t) noexcept { std::free(memory); }
+void operator delete[](void* memory, std::align_val_t) noexcept { std::free(memory); }
+void operator delete(void* memory, size_t, std::align_val_t) noexcept { std::free(memory); }
+void operator delete[](void* memory, size_t, std::align_val_t) noexcept { std::free(memory); }
@@ -1,3 +1,4 @@
+#include <atomic>
 #include <functional>
 #include <stdexcept>
 #include <string>
@@ -39,6 +40,20 @@ TEST_F(ContainerTests, Resolve_GivenNoMatchingRegistration_ThrowsException)
     ASSERT_TRUE(exceptionThrown);
 }
 
+TEST_F(ContainerTests, Resolve_GivenUnregisteredName_ThrowsException)
+{
+    givenRegistrationReturningValue(5, "Registered");
+    auto exceptionThrown = false;
+
+    try {
+        _subject.resolve<int>("Unregistered");
+    } catch (const std::invalid_argument & ex) {
+        exceptionThrown = true;
+    }
+
+    ASSERT_TRUE(exceptionThrown);
+}
+
 TEST_F(ContainerTests, Resolve_GivenMatchingRegistration_ReturnsRegisteredItem)
 {
     auto expectedValue = 5;
@@ -49,6 +64,8 @@ TEST_F(ContainerTests, Resolve_GivenMatchingRegistration_ReturnsRegisteredItem)
     ASSERT_EQ(expectedValue, result);
 }
 
+// Without the runtime check a cycle is only reported by compile().
+#if !defined(CDIF_NO_RUNTIME_CYCLE_CHECK)
 TEST_F(ContainerTests, Resolve_GivenCircularDependency_ThrowsException)
 {
     givenRegistrationReturningValue(55);
@@ -64,6 +81,21 @@ TEST_F(ContainerTests, Resolve_GivenCircularDependency_ThrowsException)
     ASSERT_TRUE(exceptionThrown);
 }
 
+TEST_F(ContainerTests, Resolve_AfterCircularDependencyWasDetected_CanResolveFormerMembersOfCycle)
+{
+    auto expectedValue = 55;
+    givenRegistrationReturningValue(expectedValue);
+    _subject.bind<SharedImplementationDecorator, int, std::shared_ptr<Interface>>().as<Interface>().build();
+    EXPECT_THROW(_subject.resolve<SharedImplementationDecorator>(), std::runtime_error);
+    _subject.bind<SimpleImplementation, int>().as<Interface>().build();
+
+    auto result = _subject.resolve<SharedImplementationDecorator>();
+
+    ASSERT_EQ(expectedValue, result.m_data);
+}
+
+#endif
+
 TEST_F(ContainerTests, Resolve_GivenMultipleResolutionsOfSameType_ResolvesSuccessfully)
 {
     auto expectedValue = 89;
@@ -105,3 +137,207 @@ TEST_F(ContainerTests, Resolve_GivenRegistrationRequiringUniquePtr_CanResolveSuc
     auto result = _subject.resolve<UniqueImplementationDecorator>();
 }
 
+
+TEST_F(ContainerTests, Resolve_GivenFrozenContainer_ReturnsRegisteredItem)
+{
+    auto expectedValue = 62;
+    givenRegistrationReturningValue(expectedValue);
+    _subject.freeze();
+
+    auto result = _subject.resolve<int>();
+
+    ASSERT_EQ(expectedValue, result);
+}
+
+TEST_F(ContainerTests, Bind_GivenFrozenContainer_ThrowsException)
+{
+    _subject.freeze();
+    auto exceptionThrown = false;
+
+    try {
+        givenRegistrationReturningValue(62);
+    } catch (const std::logic_error & ex) {
+        exceptionThrown = true;
+    }
+
+    ASSERT_TRUE(exceptionThrown);
+}
+
+TEST_F(ContainerTests, Bind_GivenUnfrozenContainer_ReplacesRegistration)
+{
+    auto expectedValue = 62;
+    givenRegistrationReturningValue(1);
+    _subject.freeze();
+    _subject.unfreeze();
+
+    givenRegistrationReturningValue(expectedValue);
+    auto result = _subject.resolve<int>();
+
+    ASSERT_EQ(expectedValue, result);
+}
+
+TEST_F(ContainerTests, Bind_GivenConcurrentResolves_ReplacesRegistration)
+{
+    auto expectedValue = 62;
+    givenRegistrationReturningValue(1);
+    _subject.bind<SimpleImplementation, int>().build();
+    auto done = std::atomic<bool>(false);
+    auto resolver = std::thread([&] () {
+        while (!done.load())
+            _subject.resolve<std::shared_ptr<SimpleImplementation>>();
+    });
+
+    for (auto i = 0; i < 100; i++)
+        givenRegistrationReturningValue(i);
+    givenRegistrationReturningValue(expectedValue);
+    done.store(true);
+    resolver.join();
+
+    ASSERT_EQ(expectedValue, _subject.resolve<SimpleImplementation>().m_data);
+}
+
+TEST_F(ContainerTests, Compile_GivenMissingDependency_ThrowsException)
+{
+    _subject.bind<SimpleImplementation, int>().build();
+    auto exceptionThrown = false;
+
+    try {
+        _subject.compile();
+    } catch (const std::invalid_argument & ex) {
+        exceptionThrown = true;
+    }
+
+    ASSERT_TRUE(exceptionThrown);
+    ASSERT_FALSE(_subject.isFrozen());
+}
+
+TEST_F(ContainerTests, Compile_GivenCircularDependency_ThrowsException)
+{
+    givenRegistrationReturningValue(55);
+    _subject.bind<SharedImplementationDecorator, int, std::shared_ptr<Interface>>().as<Interface>().build();
+
+    ASSERT_THROW(_subject.compile(), std::runtime_error);
+}
+
+TEST_F(ContainerTests, Resolve_GivenCompiledContainer_ResolvesDependencies)
+{
+    auto expectedValue = 89;
+    givenRegistrationReturningValue(expectedValue);
+    _subject.bind<SimpleImplementation, int>().as<Interface>().build();
+    _subject.bind<ComplexImplementation, int, std::shared_ptr<Interface>, std::shared_ptr<Interface>>().build();
+    _subject.compile();
+
+    auto result = _subject.resolve<ComplexImplementation>();
+
+    ASSERT_TRUE(_subject.isFrozen());
+    ASSERT_EQ(expectedValue, result.m_data);
+    ASSERT_EQ(expectedValue, result.m_obj1->m_data);
+}
+
+TEST_F(ContainerTests, Resolve_GivenRecompiledContainer_ResolvesReboundDependencies)
+{
+    auto expectedValue = 89;
+    givenRegistrationReturningValue(1);
+    _subject.bind<SimpleImplementation, int>().build();
+    _subject.compile();
+    _subject.unfreeze();
+
+    givenRegistrationReturningValue(expectedValue);
+    _subject.compile();
+    auto result = _subject.resolve<SimpleImplementation>();
+
+    ASSERT_EQ(expectedValue, result.m_data);
+}
+
+TEST_F(ContainerTests, Bind_GivenTypeRegistration_AddsOneRegistration)
+{
+    givenRegistrationReturningValue(5);
+    _subject.bind<SimpleImplementation, int>().build();
+
+    ASSERT_EQ(3u, _subject.registrationCount());
+}
+
+TEST_F(ContainerTests, Bind_GivenInterfaceRegistration_AddsRegistrationForServiceAndInterface)
+{
+    givenRegistrationReturningValue(5);
+    _subject.bind<SimpleImplementation, int>().as<Interface>().build();
+
+    ASSERT_EQ(4u, _subject.registrationCount());
+}
+
+TEST_F(ContainerTests, Resolve_GivenCompiledContainer_ResolvesDerivedVariants)
+{
+    auto expectedValue = 14;
+    givenRegistrationReturningValue(expectedValue);
+    _subject.bind<SimpleImplementation, int>().as<Interface>().build();
+    _subject.bind<UniqueImplementationDecorator, int, std::unique_ptr<Interface>>().build();
+    _subject.compile();
+
+    auto result = _subject.resolve<std::unique_ptr<UniqueImplementationDecorator>>();
+    auto* interface = _subject.resolve<Interface*>();
+
+    ASSERT_EQ(expectedValue, result->m_data);
+    ASSERT_EQ(expectedValue, interface->m_data);
+    delete interface;
+}
+
+TEST_F(ContainerTests, Bind_GivenEarlierPointerBind_LaterTypeBindOverridesIt)
+{
+    auto expectedValue = 23;
+    givenRegistrationReturningValue(expectedValue);
+    _subject.bind<SimpleImplementation*>([] () { return new SimpleImplementation(-1); }).build();
+    _subject.bind<SimpleImplementation, int>().build();
+
+    auto* result = _subject.resolve<SimpleImplementation*>();
+
+    ASSERT_EQ(expectedValue, result->m_data);
+    delete result;
+}
+
+TEST_F(ContainerTests, Bind_GivenEarlierSharedPtrBind_LaterTypeBindOverridesIt)
+{
+    auto expectedValue = 24;
+    givenRegistrationReturningValue(expectedValue);
+    _subject.bind<std::shared_ptr<SimpleImplementation>>([] () { return std::make_shared<SimpleImplementation>(-1); }).build();
+    _subject.bind<SimpleImplementation, int>().build();
+
+    auto result = _subject.resolve<std::shared_ptr<SimpleImplementation>>();
+
+    ASSERT_EQ(expectedValue, result->m_data);
+}
+
+TEST_F(ContainerTests, Bind_GivenEarlierUniquePtrBind_LaterInterfaceBindOverridesIt)
+{
+    auto expectedValue = 25;
+    givenRegistrationReturningValue(expectedValue);
+    _subject.bind<std::unique_ptr<Interface>>([] () { return std::unique_ptr<Interface>(std::make_unique<SimpleImplementation>(-1)); }).build();
+    _subject.bind<SimpleImplementation, int>().as<Interface>().build();
+
+    auto result = _subject.resolve<std::unique_ptr<Interface>>();
+
+    ASSERT_EQ(expectedValue, result->m_data);
+}
+
+TEST_F(ContainerTests, Bind_GivenEarlierFunctionBind_LaterTypeBindOverridesIt)
+{
+    auto expectedValue = 26;
+    auto factory = std::function<SimpleImplementation (int)>([] (int) { return SimpleImplementation(-1); });
+    givenRegistrationReturningValue(factory);
+    _subject.bind<SimpleImplementation, int>().build();
+
+    auto result = _subject.resolve<std::function<SimpleImplementation (int)>>();
+
+    ASSERT_EQ(expectedValue, result(expectedValue).m_data);
+}
+
+TEST_F(ContainerTests, Bind_GivenLaterSharedPtrBind_OverridesEarlierTypeBind)
+{
+    auto expectedValue = 27;
+    givenRegistrationReturningValue(1);
+    _subject.bind<SimpleImplementation, int>().build();
+    _subject.bind<std::shared_ptr<SimpleImplementation>>([=] () { return std::make_shared<SimpleImplementation>(expectedValue); }).build();
+
+    auto result = _subject.resolve<std::shared_ptr<SimpleImplementation>>();
+
+    ASSERT_EQ(expectedValue, result->m_data);
+}
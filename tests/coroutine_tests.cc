@@ -0,0 +1,191 @@
+#include <coroutine>
+#include <deque>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "cdif.h"
+
+namespace {
+    // A single threaded event loop, awaiting yield() lets the other
+    // coroutines on the loop run first.
+    class EventLoop
+    {
+        private:
+            std::deque<std::coroutine_handle<>> m_ready;
+
+        public:
+            auto yield()
+            {
+                struct Awaiter
+                {
+                    EventLoop& loop;
+
+                    bool await_ready() const noexcept { return false; }
+                    void await_suspend(std::coroutine_handle<> handle) const { loop.m_ready.push_back(handle); }
+                    void await_resume() const noexcept {}
+                };
+                return Awaiter { *this };
+            }
+
+            void run()
+            {
+                while (!m_ready.empty()) {
+                    auto handle = m_ready.front();
+                    m_ready.pop_front();
+                    handle.resume();
+                }
+            }
+    };
+
+    struct Detached
+    {
+        struct promise_type
+        {
+            Detached get_return_object() const noexcept { return {}; }
+            std::suspend_never initial_suspend() const noexcept { return {}; }
+            std::suspend_never final_suspend() const noexcept { return {}; }
+            void return_void() const noexcept {}
+            void unhandled_exception() const noexcept { std::terminate(); }
+        };
+    };
+
+    template <typename T, typename TResult>
+    Detached awaitInto(cdif::Task<T> task, std::optional<TResult>& result, std::string& error)
+    {
+        try {
+            result.emplace(co_await task);
+        } catch (const std::exception& ex) {
+            error = ex.what();
+        }
+    }
+
+    template <int Id>
+    struct Connection
+    {
+        int m_id;
+    };
+
+    struct Client
+    {
+        int m_first;
+        int m_second;
+        int m_value;
+    };
+}
+
+class CoroutineTests : public ::testing::Test
+{
+    protected:
+        cdif::Container _subject;
+        EventLoop _loop;
+        std::vector<std::string> _log;
+
+        template <int Id>
+        void givenAsyncConnection()
+        {
+            _subject.bindAsync<Connection<Id>>(std::function([this] () -> cdif::Task<Connection<Id>>
+                {
+                    _log.push_back("open" + std::to_string(Id));
+                    co_await _loop.yield();
+                    _log.push_back("opened" + std::to_string(Id));
+                    co_return Connection<Id> { Id };
+                })).build();
+        }
+
+        template <typename T>
+        std::optional<T> run(cdif::Task<T> task)
+        {
+            auto result = std::optional<T>();
+            auto error = std::string();
+            awaitInto(std::move(task), result, error);
+            _loop.run();
+            return result;
+        }
+};
+
+TEST_F(CoroutineTests, ResolveCo_GivenAsyncFactory_ResolvesItsResult)
+{
+    givenAsyncConnection<1>();
+
+    auto result = run(_subject.resolveCo<Connection<1>>());
+
+    ASSERT_TRUE(result.has_value());
+    ASSERT_EQ(1, result->m_id);
+}
+
+TEST_F(CoroutineTests, ResolveCo_GivenSynchronousRegistration_ResolvesItWhenAwaited)
+{
+    _subject.bind<int>([] () { return 42; }).build();
+
+    auto result = run(_subject.resolveCo<int>());
+
+    ASSERT_EQ(42, result.value());
+}
+
+TEST_F(CoroutineTests, ResolveCo_GivenAsyncDependencies_InitializesThemConcurrently)
+{
+    givenAsyncConnection<1>();
+    givenAsyncConnection<2>();
+    _subject.bind<int>([] () { return 7; }).build();
+    _subject.bindAsync<Client, Connection<1>, Connection<2>, int>(std::function(
+        [] (Connection<1> first, Connection<2> second, int value) -> cdif::Task<Client>
+        {
+            co_return Client { first.m_id, second.m_id, value };
+        })).build();
+
+    auto result = run(_subject.resolveCo<Client>());
+
+    ASSERT_EQ(2, result->m_second);
+    ASSERT_EQ(7, result->m_value);
+    ASSERT_EQ(std::vector<std::string>({ "open1", "open2", "opened1", "opened2" }), _log);
+}
+
+TEST_F(CoroutineTests, ResolveCo_GivenAsyncSingleton_BuildsItOnceForConcurrentAwaiters)
+{
+    _subject.bindAsync<Connection<1>>(std::function([this] () -> cdif::Task<Connection<1>>
+        {
+            _log.push_back("open1");
+            co_await _loop.yield();
+            co_return Connection<1> { 1 };
+        })).in<cdif::Scope::Singleton>().build();
+
+    auto first = std::optional<std::reference_wrapper<Connection<1>>>();
+    auto second = std::optional<std::reference_wrapper<Connection<1>>>();
+    auto error = std::string();
+    awaitInto(_subject.resolveCo<Connection<1>&>(), first, error);
+    awaitInto(_subject.resolveCo<Connection<1>&>(), second, error);
+    _loop.run();
+
+    ASSERT_EQ(&first->get(), &second->get());
+    ASSERT_EQ(std::vector<std::string>({ "open1" }), _log);
+}
+
+TEST_F(CoroutineTests, ResolveCo_GivenThrowingAsyncFactory_ThrowsFromAwait)
+{
+    _subject.bindAsync<Connection<1>>(std::function([this] () -> cdif::Task<Connection<1>>
+        {
+            co_await _loop.yield();
+            throw std::runtime_error("connection refused");
+        })).build();
+
+    auto result = std::optional<Connection<1>>();
+    auto error = std::string();
+    awaitInto(_subject.resolveCo<Connection<1>>(), result, error);
+    _loop.run();
+
+    ASSERT_FALSE(result.has_value());
+    ASSERT_EQ("connection refused", error);
+}
+
+TEST_F(CoroutineTests, ResolveCo_GivenNamedAsyncFactory_ResolvesByName)
+{
+    _subject.bindAsync<int>(std::function([] () -> cdif::Task<int> { co_return 5; })).named("five").build();
+
+    auto result = run(_subject.resolveCo<int>("five"));
+
+    ASSERT_EQ(5, result.value());
+}
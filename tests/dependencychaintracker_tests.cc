@@ -0,0 +1,78 @@
+#include <thread>
+
+#include <gtest/gtest.h>
+
+#include "cdif.h"
+
+class DependencyChainTrackerTests : public ::testing::Test
+{
+    protected:
+        cdif::DependencyChainTracker _subject;
+        int _owner = 0;
+        int _otherOwner = 0;
+
+        cdif::ServiceKey keyFor(size_t name)
+        {
+            return cdif::ServiceKey { cdif::type_key<int>, name };
+        }
+};
+
+TEST_F(DependencyChainTrackerTests, Contains_GivenEmptyChain_ReturnsFalse)
+{
+    ASSERT_FALSE(_subject.contains(&_owner, keyFor(0)));
+}
+
+TEST_F(DependencyChainTrackerTests, Contains_GivenPushedKey_ReturnsTrue)
+{
+    _subject.push(&_owner, keyFor(0));
+
+    ASSERT_TRUE(_subject.contains(&_owner, keyFor(0)));
+}
+
+TEST_F(DependencyChainTrackerTests, Contains_GivenKeyPushedByOtherOwner_ReturnsFalse)
+{
+    _subject.push(&_otherOwner, keyFor(0));
+
+    ASSERT_FALSE(_subject.contains(&_owner, keyFor(0)));
+}
+
+TEST_F(DependencyChainTrackerTests, Pop_GivenPushedKey_RemovesKey)
+{
+    _subject.push(&_owner, keyFor(0));
+
+    _subject.pop();
+
+    ASSERT_FALSE(_subject.contains(&_owner, keyFor(0)));
+    ASSERT_TRUE(_subject.isEmpty());
+}
+
+TEST_F(DependencyChainTrackerTests, Push_GivenChainDeeperThanInlineStorage_TracksAllKeys)
+{
+    const size_t depth = 100;
+    for (size_t i = 0; i < depth; i++)
+        _subject.push(&_owner, keyFor(i));
+
+    for (size_t i = 0; i < depth; i++)
+        ASSERT_TRUE(_subject.contains(&_owner, keyFor(i)));
+
+    for (size_t i = 0; i < depth; i++)
+        _subject.pop();
+
+    ASSERT_TRUE(_subject.isEmpty());
+}
+
+TEST_F(DependencyChainTrackerTests, GetThisChain_GivenDifferentThreads_ReturnsDifferentChains)
+{
+    auto& chain = cdif::PerThreadDependencyChainTracker::getThisChain();
+    chain.push(&_owner, keyFor(0));
+    auto containedInOtherThread = true;
+
+    auto t = std::thread([&] ()
+        {
+            containedInOtherThread = cdif::PerThreadDependencyChainTracker::getThisChain().contains(&_owner, keyFor(0));
+        });
+    t.join();
+    chain.pop();
+
+    ASSERT_FALSE(containedInOtherThread);
+}
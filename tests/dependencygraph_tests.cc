@@ -0,0 +1,42 @@
+#include <functional>
+#include <memory>
+
+#include <gtest/gtest.h>
+
+#include "cdif.h"
+#include "test_types.h"
+
+using AcyclicGraph = cdif::DependencyGraph<
+    cdif::DependencyNode<ComplexImplementation, int, std::shared_ptr<Interface>, std::shared_ptr<Interface>>,
+    cdif::DependencyNode<Interface, SimpleImplementation>,
+    cdif::DependencyNode<SimpleImplementation, int>>;
+
+using SelfReferencingGraph = cdif::DependencyGraph<
+    cdif::DependencyNode<Interface, SharedImplementationDecorator>,
+    cdif::DependencyNode<SharedImplementationDecorator, int, std::shared_ptr<Interface>>>;
+
+using IndirectCycleGraph = cdif::DependencyGraph<
+    cdif::DependencyNode<Interface, UniqueImplementationDecorator>,
+    cdif::DependencyNode<UniqueImplementationDecorator, int, std::unique_ptr<ComplexImplementation>>,
+    cdif::DependencyNode<ComplexImplementation, int, Interface*, std::shared_ptr<Interface>>>;
+
+static_assert(AcyclicGraph::is_acyclic);
+static_assert(cdif::is_acyclic_graph_v<AcyclicGraph>);
+static_assert(!cdif::is_acyclic_graph_v<SelfReferencingGraph>);
+static_assert(!cdif::is_acyclic_graph_v<IndirectCycleGraph>);
+static_assert(cdif::is_acyclic_graph_v<cdif::DependencyGraph<>>);
+
+TEST(DependencyGraphTests, IsAcyclic_GivenGraphWithoutCycles_ReturnsTrue)
+{
+    ASSERT_TRUE(AcyclicGraph::is_acyclic);
+}
+
+TEST(DependencyGraphTests, IsAcyclicGraph_GivenServiceDependingOnItsOwnInterface_ReturnsFalse)
+{
+    ASSERT_FALSE(cdif::is_acyclic_graph_v<SelfReferencingGraph>);
+}
+
+TEST(DependencyGraphTests, IsAcyclicGraph_GivenIndirectCycle_ReturnsFalse)
+{
+    ASSERT_FALSE(cdif::is_acyclic_graph_v<IndirectCycleGraph>);
+}
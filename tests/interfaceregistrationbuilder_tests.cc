@@ -68,3 +68,36 @@ TEST_F(InterfaceRegistrationBuilderTests, Resolve_GivenInterfaceRegistration_Can
 
     ASSERT_EQ(expectedValue, result->m_data);
 }
+
+TEST_F(InterfaceRegistrationBuilderTests, Resolve_GivenMemoryResource_AllocatesSharedPtrFromResource)
+{
+    auto resource = CountingMemoryResource();
+    givenRegistrationReturningValue(343);
+    _subject.bind<SimpleImplementation, int>().withMemoryResource(&resource).as<Interface>().build();
+
+    {
+        auto result = _subject.resolve<std::shared_ptr<Interface>>();
+
+        ASSERT_EQ(343, result->m_data);
+        ASSERT_EQ(1u, resource.allocations);
+    }
+
+    ASSERT_EQ(1u, resource.deallocations);
+}
+
+TEST_F(InterfaceRegistrationBuilderTests, Resolve_GivenMemoryResource_DestroysPmrUniquePtrThroughInterface)
+{
+    auto resource = CountingMemoryResource();
+    givenRegistrationReturningValue(343);
+    _subject.setMemoryResource(&resource);
+    _subject.bind<SimpleImplementation, int>().as<Interface>().build();
+
+    {
+        auto result = _subject.resolve<cdif::pmr_unique_ptr<Interface>>();
+
+        ASSERT_EQ(343, result->m_data);
+        ASSERT_EQ(1u, resource.allocations);
+    }
+
+    ASSERT_EQ(1u, resource.deallocations);
+}
@@ -0,0 +1,176 @@
+#include <atomic>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "cdif.h"
+
+namespace {
+    std::atomic<int> heavyCount(0);
+
+    struct Heavy
+    {
+        int m_value;
+
+        Heavy(int value) : m_value(value) { heavyCount++; }
+    };
+
+    struct Consumer
+    {
+        cdif::Lazy<std::shared_ptr<Heavy>> m_heavy;
+
+        Consumer(cdif::Lazy<std::shared_ptr<Heavy>> heavy) : m_heavy(heavy) {}
+    };
+
+    struct Parent;
+
+    struct Child
+    {
+        cdif::Lazy<Parent&> m_parent;
+
+        Child(cdif::Lazy<Parent&> parent) : m_parent(parent) {}
+    };
+
+    struct Parent
+    {
+        std::shared_ptr<Child> m_child;
+
+        Parent(std::shared_ptr<Child> child) : m_child(child) {}
+    };
+}
+
+class LazyTests : public ::testing::Test
+{
+    protected:
+        cdif::Container _subject;
+
+        void SetUp() override
+        {
+            heavyCount = 0;
+            _subject.bind<int>([] () { return 7; }).build();
+            _subject.bind<Heavy, int>().build();
+        }
+};
+
+TEST_F(LazyTests, Resolve_GivenRegisteredType_DoesNotBuildUntilDereferenced)
+{
+    auto lazy = _subject.resolve<cdif::Lazy<Heavy>>();
+
+    ASSERT_EQ(0, heavyCount.load());
+    ASSERT_FALSE(lazy.isCreated());
+    ASSERT_EQ(7, lazy->m_value);
+    ASSERT_TRUE(lazy.isCreated());
+}
+
+TEST_F(LazyTests, Get_GivenCopies_BuildsOneInstance)
+{
+    auto lazy = _subject.resolve<cdif::Lazy<Heavy>>();
+    auto copy = lazy;
+
+    auto& first = lazy.get();
+    auto& second = *copy;
+
+    ASSERT_EQ(&first, &second);
+    ASSERT_EQ(1, heavyCount.load());
+}
+
+TEST_F(LazyTests, Resolve_GivenName_ResolvesNamedRegistration)
+{
+    _subject.bind<int>([] () { return 9; }).named("other").build();
+
+    auto lazy = _subject.resolve<cdif::Lazy<int>>("other");
+
+    ASSERT_EQ(9, *lazy);
+}
+
+TEST_F(LazyTests, Resolve_GivenLazyConstructorArgument_DefersDependency)
+{
+    _subject.bind<Consumer, cdif::Lazy<std::shared_ptr<Heavy>>>().build();
+    _subject.compile();
+
+    auto consumer = _subject.resolve<Consumer>();
+
+    ASSERT_EQ(0, heavyCount.load());
+    ASSERT_EQ(7, (*consumer.m_heavy)->m_value);
+    ASSERT_EQ(1, heavyCount.load());
+}
+
+TEST_F(LazyTests, Compile_GivenCycleThroughLazy_ResolvesBothSides)
+{
+    _subject.bind<Parent, std::shared_ptr<Child>>().in<cdif::Scope::Singleton>().build();
+    _subject.bind<Child, cdif::Lazy<Parent&>>().build();
+    _subject.compile();
+
+    auto& parent = _subject.resolve<Parent&>();
+
+    ASSERT_EQ(&parent, &parent.m_child->m_parent.get());
+}
+
+TEST_F(LazyTests, Get_GivenUnregisteredType_ThrowsOnDereference)
+{
+    auto lazy = _subject.resolve<cdif::Lazy<std::string>>();
+
+    ASSERT_THROW(lazy.get(), std::invalid_argument);
+    ASSERT_FALSE(lazy.isCreated());
+}
+
+TEST_F(LazyTests, Get_FromManyThreads_BuildsOneInstance)
+{
+    auto lazy = _subject.resolve<cdif::Lazy<Heavy>>();
+    auto instances = std::vector<Heavy*>(8);
+    auto threads = std::vector<std::thread>();
+
+    for (size_t i = 0; i < instances.size(); i++)
+        threads.push_back(std::thread([&, i] () { instances[i] = &lazy.get(); }));
+    for (auto& t : threads)
+        t.join();
+
+    ASSERT_EQ(1, heavyCount.load());
+    for (auto* instance : instances)
+        ASSERT_EQ(instances.front(), instance);
+}
+
+TEST_F(LazyTests, ResolveLazyList_GivenListRegistration_BuildsOnlyElementsReached)
+{
+    _subject.bindList<std::shared_ptr<Heavy>, std::shared_ptr<Heavy>, std::shared_ptr<Heavy>, std::shared_ptr<Heavy>>().build();
+
+    auto list = _subject.resolve<cdif::LazyList<std::shared_ptr<Heavy>>>();
+
+    ASSERT_EQ(3u, list.size());
+    ASSERT_EQ(0, heavyCount.load());
+
+    for (auto& heavy : list) {
+        if (heavy->m_value == 7)
+            break;
+    }
+
+    ASSERT_EQ(1, heavyCount.load());
+    ASSERT_TRUE(list.isCreated(0));
+    ASSERT_FALSE(list.isCreated(1));
+}
+
+TEST_F(LazyTests, ResolveLazyList_GivenCopies_ShareReachedElements)
+{
+    _subject.bindList<std::shared_ptr<Heavy>, std::shared_ptr<Heavy>, std::shared_ptr<Heavy>>().build();
+
+    auto list = _subject.resolve<cdif::LazyList<std::shared_ptr<Heavy>>>();
+    auto copy = list;
+
+    ASSERT_EQ(list[1], copy.at(1));
+    ASSERT_NE(list[1], list.create(1));
+    ASSERT_EQ(2, heavyCount.load());
+}
+
+TEST_F(LazyTests, ResolveLazyList_EachResolve_BuildsItsOwnElements)
+{
+    _subject.bindList<std::shared_ptr<Heavy>, std::shared_ptr<Heavy>>().build();
+
+    auto first = _subject.resolve<cdif::LazyList<std::shared_ptr<Heavy>>>();
+    auto second = _subject.resolve<cdif::LazyList<std::shared_ptr<Heavy>>>();
+
+    ASSERT_NE(first[0], second[0]);
+    ASSERT_EQ(2, heavyCount.load());
+}
@@ -0,0 +1,119 @@
+#include <memory>
+#include <stdexcept>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "cdif.h"
+#include "test_types.h"
+
+namespace {
+    template <int Id>
+    class OrderTracker
+    {
+        private:
+            std::shared_ptr<std::vector<int>> m_log;
+
+        public:
+            OrderTracker(std::shared_ptr<std::vector<int>> log) : m_log(log) {}
+            OrderTracker(OrderTracker&&) = default;
+
+            ~OrderTracker()
+            {
+                if (m_log)
+                    m_log->push_back(Id);
+            }
+    };
+
+    struct Request
+    {
+        SimpleImplementation& m_first;
+        SimpleImplementation& m_second;
+
+        Request(SimpleImplementation& first, SimpleImplementation& second) : m_first(first), m_second(second) {}
+    };
+}
+
+class LifetimeScopeTests : public ::testing::Test
+{
+    protected:
+        cdif::Container _subject;
+
+        void SetUp() override
+        {
+            _subject.bind<int>([] () { return 5; }).build();
+            _subject.bind<SimpleImplementation, int>().in<cdif::Scope::PerScope>().build();
+        }
+};
+
+TEST_F(LifetimeScopeTests, Resolve_GivenPerScopeRegistration_ResolvesSameInstanceWithinScope)
+{
+    auto scope = _subject.beginScope();
+
+    auto* first = scope.resolve<SimpleImplementation*>();
+    auto& second = scope.resolve<SimpleImplementation&>();
+    auto third = scope.resolve<std::shared_ptr<SimpleImplementation>>();
+
+    ASSERT_EQ(first, std::addressof(second));
+    ASSERT_EQ(first, third.get());
+}
+
+TEST_F(LifetimeScopeTests, Resolve_GivenSeparateScopes_ResolvesInstancePerScope)
+{
+    auto first = _subject.beginScope();
+    auto second = _subject.beginScope();
+
+    ASSERT_NE(first.resolve<SimpleImplementation*>(), second.resolve<SimpleImplementation*>());
+}
+
+TEST_F(LifetimeScopeTests, Resolve_GivenPerScopeDependencies_SharesInstanceAcrossGraph)
+{
+    _subject.bind<Request, SimpleImplementation&, SimpleImplementation&>().build();
+    auto scope = _subject.beginScope();
+
+    auto request = scope.resolve<Request>();
+
+    ASSERT_EQ(std::addressof(request.m_first), std::addressof(request.m_second));
+    ASSERT_EQ(std::addressof(request.m_first), scope.resolve<SimpleImplementation*>());
+}
+
+TEST_F(LifetimeScopeTests, Resolve_GivenPerScopeRegistrationOutsideScope_ThrowsException)
+{
+    ASSERT_THROW(_subject.resolve<SimpleImplementation*>(), std::logic_error);
+}
+
+TEST_F(LifetimeScopeTests, Resolve_GivenNestedScopes_RestoresOuterScope)
+{
+    _subject.bind<Request, SimpleImplementation&, SimpleImplementation&>()
+        .withIndexedParameterFrom<1, SimpleImplementation&>([] (const cdif::Container& ctx) -> SimpleImplementation&
+            {
+                static auto inner = std::unique_ptr<cdif::LifetimeScope>();
+                inner = std::make_unique<cdif::LifetimeScope>(ctx);
+                return inner->resolve<SimpleImplementation&>();
+            })
+        .build();
+    auto scope = _subject.beginScope();
+
+    auto request = scope.resolve<Request>();
+
+    ASSERT_NE(std::addressof(request.m_first), std::addressof(request.m_second));
+    ASSERT_EQ(std::addressof(request.m_first), scope.resolve<SimpleImplementation*>());
+}
+
+TEST_F(LifetimeScopeTests, Destructor_DestroysInstancesInReverseOrderOfConstruction)
+{
+    auto log = std::make_shared<std::vector<int>>();
+    _subject.bind<std::shared_ptr<std::vector<int>>>([log] () { return log; }).build();
+    _subject.bind<OrderTracker<1>, std::shared_ptr<std::vector<int>>>().in<cdif::Scope::PerScope>().build();
+    _subject.bind<OrderTracker<2>, std::shared_ptr<std::vector<int>>>().in<cdif::Scope::PerScope>().build();
+
+    {
+        auto scope = _subject.beginScope();
+        scope.resolve<OrderTracker<1>&>();
+        scope.resolve<OrderTracker<2>&>();
+
+        ASSERT_TRUE(log->empty());
+    }
+
+    ASSERT_EQ(std::vector<int>({ 2, 1 }), *log);
+}
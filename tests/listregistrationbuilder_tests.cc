@@ -4,9 +4,13 @@
 #include <gtest/gtest.h>
 
 #include <array>
+#include <chrono>
 #include <list>
 #include <memory>
+#include <memory_resource>
+#include <stdexcept>
 #include <string>
+#include <thread>
 #include <vector>
 
 class ListRegistrationBuilderTests : public ::testing::Test
@@ -357,3 +361,95 @@ TEST_F(ListRegistrationBuilderTests, Resolve_GivenListRegistrationInSingletonSco
     ASSERT_EQ(list.size(), 3);
 }
 
+
+TEST_F(ListRegistrationBuilderTests, Bind_GivenListRegistration_AddsOneRegistrationForAllListTypes)
+{
+    givenRegistrationReturningValue(333);
+    _subject.bind<SimpleImplementation, int>().build();
+    _subject.bindList<std::shared_ptr<Interface>, std::shared_ptr<SimpleImplementation>>().build();
+
+    ASSERT_EQ(4u, _subject.registrationCount());
+}
+
+TEST_F(ListRegistrationBuilderTests, Resolve_GivenListRegistrationWithMemoryResource_AllocatesPmrVectorFromResource)
+{
+    auto resource = CountingMemoryResource();
+    givenRegistrationReturningValue(333);
+    _subject.bind<SimpleImplementation, int>().build();
+    _subject.bindList<std::shared_ptr<Interface>, std::shared_ptr<SimpleImplementation>, std::shared_ptr<SimpleImplementation>>()
+        .withMemoryResource(&resource)
+        .build();
+
+    {
+        auto list = _subject.resolve<std::pmr::vector<std::shared_ptr<Interface>>>();
+
+        ASSERT_EQ(list.size(), 2);
+        ASSERT_EQ(list.get_allocator().resource(), &resource);
+        ASSERT_EQ(1u, resource.allocations);
+    }
+
+    ASSERT_EQ(1u, resource.deallocations);
+}
+
+TEST_F(ListRegistrationBuilderTests, Resolve_GivenParallelListRegistration_ResolvesElementsInOrder)
+{
+    givenRegistrationReturningValue(333);
+    _subject.bind<SimpleImplementation, int>().as<Interface>().build();
+    _subject.bind<SimpleImplementation, int>().build();
+    _subject.bind<SharedImplementationDecorator, int, std::shared_ptr<Interface>>().build();
+    _subject.bind<UniqueImplementationDecorator, int, std::unique_ptr<Interface>>().build();
+    _subject.bindList<std::shared_ptr<Interface>,
+                      std::shared_ptr<SimpleImplementation>,
+                      std::shared_ptr<SharedImplementationDecorator>,
+                      std::shared_ptr<UniqueImplementationDecorator>>()
+        .inParallel()
+        .build();
+
+    for (auto i = 0; i < 100; i++) {
+        auto list = _subject.resolve<std::vector<std::shared_ptr<Interface>>>();
+
+        ASSERT_EQ(list.size(), 3);
+        ASSERT_NE(nullptr, std::dynamic_pointer_cast<SimpleImplementation>(list[0]));
+        ASSERT_NE(nullptr, std::dynamic_pointer_cast<SharedImplementationDecorator>(list[1]));
+        ASSERT_NE(nullptr, std::dynamic_pointer_cast<UniqueImplementationDecorator>(list[2]));
+    }
+}
+
+TEST_F(ListRegistrationBuilderTests, Resolve_GivenParallelListOfPerThreadElements_ResolvesCallingThreadInstance)
+{
+    _subject.bind<int>([] ()
+        {
+            std::this_thread::sleep_for(std::chrono::milliseconds(5));
+            return 333;
+        }).build();
+    _subject.bind<SimpleImplementation, int>().in<cdif::Scope::PerThread>().build();
+    _subject.bindList<Interface*,
+                      SimpleImplementation*, SimpleImplementation*, SimpleImplementation*, SimpleImplementation*,
+                      SimpleImplementation*, SimpleImplementation*, SimpleImplementation*, SimpleImplementation*>()
+        .inParallel()
+        .build();
+
+    auto list = _subject.resolve<std::vector<Interface*>>();
+    auto* expected = _subject.resolve<SimpleImplementation*>();
+
+    ASSERT_EQ(8u, list.size());
+    for (auto* element : list)
+        ASSERT_EQ(expected, element);
+}
+
+TEST_F(ListRegistrationBuilderTests, Resolve_GivenParallelListRegistrationWithFailingElement_Throws)
+{
+    givenRegistrationReturningValue(333);
+    _subject.bind<SimpleImplementation, int>().build();
+    _subject.bind<std::shared_ptr<SharedImplementationDecorator>>([] () -> std::shared_ptr<SharedImplementationDecorator>
+        {
+            throw std::runtime_error("failed");
+        }).build();
+    _subject.bindList<std::shared_ptr<Interface>,
+                      std::shared_ptr<SimpleImplementation>,
+                      std::shared_ptr<SharedImplementationDecorator>>()
+        .inParallel()
+        .build();
+
+    ASSERT_THROW(_subject.resolve<std::vector<std::shared_ptr<Interface>>>(), std::runtime_error);
+}
@@ -0,0 +1,158 @@
+#include <atomic>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <thread>
+
+#include <gtest/gtest.h>
+
+#include "cdif.h"
+#include "test_types.h"
+
+namespace {
+    struct Worker
+    {
+        cdif::Provider<std::unique_ptr<SimpleImplementation>> m_factory;
+
+        Worker(cdif::Provider<std::unique_ptr<SimpleImplementation>> factory) : m_factory(factory) {}
+    };
+}
+
+class ProviderTests : public ::testing::Test
+{
+    protected:
+        cdif::Container _subject;
+
+        void givenValue(int value, const std::string& name = "")
+        {
+            _subject.bind<int>([value] () { return value; }).named(name).build();
+        }
+};
+
+TEST_F(ProviderTests, Call_GivenRegisteredType_ResolvesNewInstanceEachCall)
+{
+    givenValue(5);
+    _subject.bind<SimpleImplementation, int>().build();
+    auto provider = _subject.provider<std::unique_ptr<SimpleImplementation>>();
+
+    auto first = provider();
+    auto second = provider();
+
+    ASSERT_EQ(5, first->m_data);
+    ASSERT_NE(first.get(), second.get());
+}
+
+TEST_F(ProviderTests, Call_GivenName_ResolvesNamedRegistration)
+{
+    givenValue(5);
+    givenValue(8, "other");
+
+    auto provider = _subject.provider<int>("other");
+
+    ASSERT_EQ(8, provider());
+}
+
+TEST_F(ProviderTests, Call_GivenSingletonRegistration_ResolvesSameInstance)
+{
+    givenValue(5);
+    _subject.bind<SimpleImplementation, int>().in<cdif::Scope::Singleton>().build();
+    auto provider = _subject.provider<SimpleImplementation*>();
+
+    ASSERT_EQ(provider(), provider());
+    ASSERT_EQ(provider(), _subject.resolve<SimpleImplementation*>());
+}
+
+TEST_F(ProviderTests, Call_GivenUnregisteredType_ThrowsException)
+{
+    auto provider = _subject.provider<int>();
+
+    ASSERT_FALSE(provider.isBound());
+    ASSERT_THROW(provider(), std::invalid_argument);
+}
+
+TEST_F(ProviderTests, Call_GivenTypeBoundAfterProviderWasCreated_ResolvesRegistration)
+{
+    auto provider = _subject.provider<int>("late");
+
+    givenValue(3, "late");
+
+    ASSERT_TRUE(provider.isBound());
+    ASSERT_EQ(3, provider());
+}
+
+TEST_F(ProviderTests, Call_GivenReboundRegistration_ResolvesNewRegistration)
+{
+    givenValue(5);
+    auto provider = _subject.provider<int>();
+
+    givenValue(6);
+
+    ASSERT_EQ(6, provider());
+}
+
+TEST_F(ProviderTests, Call_GivenRegistrationReboundAfterUnfreeze_ResolvesNewRegistration)
+{
+    givenValue(5);
+    _subject.freeze();
+    auto provider = _subject.provider<int>();
+    ASSERT_EQ(5, provider());
+
+    _subject.unfreeze();
+    givenValue(6);
+    _subject.freeze();
+
+    ASSERT_EQ(6, provider());
+}
+
+TEST_F(ProviderTests, Call_WhileRegistrationIsReboundOnAnotherThread_ResolvesBoundValue)
+{
+    auto prefix = std::string("a value too long for the small string buffer ");
+    _subject.bind<std::string>([prefix] () { return prefix + "0"; }).build();
+    auto provider = _subject.provider<std::string>();
+    auto stop = std::atomic<bool>(false);
+    auto mismatches = std::atomic<int>(0);
+
+    auto caller = std::thread([&] ()
+        {
+            while (!stop.load())
+                if (provider().compare(0, prefix.size(), prefix) != 0)
+                    mismatches++;
+        });
+
+    for (auto i = 1; i <= 200; i++) {
+        auto value = prefix + std::to_string(i);
+        _subject.bind<std::string>([value] () { return value; }).build();
+    }
+    stop = true;
+    caller.join();
+
+    ASSERT_EQ(0, mismatches.load());
+    ASSERT_EQ(prefix + "200", provider());
+}
+
+TEST_F(ProviderTests, Resolve_GivenProviderConstructorArgument_InjectsProvider)
+{
+    givenValue(5);
+    _subject.bind<SimpleImplementation, int>().build();
+    _subject.bind<Worker, cdif::Provider<std::unique_ptr<SimpleImplementation>>>().build();
+    _subject.compile();
+
+    auto worker = _subject.resolve<Worker>();
+
+    ASSERT_EQ(5, worker.m_factory()->m_data);
+}
+
+TEST_F(ProviderTests, Resolve_GivenProviderArgumentAfterRebind_InjectsProviderFollowingRegistration)
+{
+    auto expectedValue = 8;
+    givenValue(5);
+    _subject.bind<SimpleImplementation, int>().build();
+    _subject.bind<Worker, cdif::Provider<std::unique_ptr<SimpleImplementation>>>().build();
+    auto first = _subject.resolve<Worker>();
+
+    givenValue(expectedValue);
+    auto second = _subject.resolve<Worker>();
+
+    ASSERT_EQ(expectedValue, first.m_factory()->m_data);
+    ASSERT_EQ(expectedValue, second.m_factory()->m_data);
+}
@@ -1,5 +1,7 @@
 #include <any>
+#include <atomic>
 #include <functional>
+#include <memory>
 #include <stdexcept>
 #include <string>
 #include <thread>
@@ -14,18 +16,19 @@ class RegistrarTests : public ::testing::Test
     protected:
         cdif::Registrar _subject;
         cdif::Container _container;
+        cdif::ServiceNameFactory _serviceNameFactory;
         std::hash<std::thread::id> _hasher;
 
-        std::string givenRegistrationWithThreadUniqueName()
+        cdif::ServiceKey givenRegistrationWithThreadUniqueName()
         {
             auto tid = getTid();
-            auto name = std::string("UniqueName") + tid;
+            auto key = _serviceNameFactory.create<std::string>(std::string("UniqueName") + tid);
 
             std::function<std::string (const cdif::Container&)> functor = [tid] (const cdif::Container &) { return tid; };
             auto registration = cdif::Registration(functor);
-            _subject.bind(registration, name);
+            _subject.bind(registration, key);
 
-            return name;
+            return key;
         }
 
         std::string getTid()
@@ -33,6 +36,21 @@ class RegistrarTests : public ::testing::Test
             return std::to_string(_hasher(std::this_thread::get_id()));
         }
 
+        cdif::Registration givenRegistrationWithVariants(int value)
+        {
+            std::function<int (const cdif::Container&)> resolver = [value] (const cdif::Container&) { return value; };
+            auto variants = std::make_shared<const cdif::RegistrationVariants>([value] (cdif::TypeKey type)
+                {
+                    if (type != cdif::type_key<std::shared_ptr<int>>)
+                        return std::unique_ptr<cdif::Registration>();
+
+                    std::function<std::shared_ptr<int> (const cdif::Container&)> variant =
+                        [value] (const cdif::Container&) { return std::make_shared<int>(value); };
+                    return std::make_unique<cdif::Registration>(variant);
+                });
+            return cdif::Registration(resolver, {}, nullptr, nullptr, variants);
+        }
+
     public:
         RegistrarTests() : _subject(cdif::Registrar()), _container(cdif::Container())
         {
@@ -42,11 +60,11 @@ class RegistrarTests : public ::testing::Test
 
 TEST_F(RegistrarTests, getRegistration_GivenNoMatch_ThrowsException)
 {
-    auto name = std::string("Unregistered Name");
+    auto key = _serviceNameFactory.find<int>("Unregistered Name");
     auto exceptionThrown = false;
 
     try {
-        _subject.getRegistration<int>(name);
+        _subject.getRegistration<int>(key);
     } catch (const std::invalid_argument & ex) {
         exceptionThrown = true;
     }
@@ -56,11 +74,11 @@ TEST_F(RegistrarTests, getRegistration_GivenNoMatch_ThrowsException)
 
 TEST_F(RegistrarTests, getRegistration_GivenMatchingRegistration_ReturnsFunctor)
 {
-    auto name = givenRegistrationWithThreadUniqueName();
+    auto key = givenRegistrationWithThreadUniqueName();
     auto expectedValue = getTid();
 
-    auto & registration = _subject.getRegistration<std::string>(name);
-    auto result = registration->resolve<std::string>(_container);
+    auto & registration = _subject.getRegistration<std::string>(key);
+    auto result = registration.resolve<std::string>(_container);
 
     ASSERT_EQ(expectedValue, result);
 }
@@ -70,8 +88,134 @@ TEST_F(RegistrarTests, Registrar_IsThreadSafeBetweenMultipleReadsAndWrites)
     const auto threadCount = 100;
     auto functor = [&] (){
         auto tid = getTid();
-        auto name = givenRegistrationWithThreadUniqueName();
-        _subject.getRegistration<std::string>(name);
+        auto key = givenRegistrationWithThreadUniqueName();
+        _subject.getRegistration<std::string>(key);
+    };
+
+    auto threads = std::vector<std::thread>();
+
+    for (auto i = 0; i < threadCount; i++)
+        threads.push_back(std::thread(functor));
+
+    for (auto & t : threads)
+        t.join();
+}
+
+TEST_F(RegistrarTests, bind_GivenFrozenRegistrar_ThrowsException)
+{
+    _subject.freeze();
+    auto exceptionThrown = false;
+
+    try {
+        givenRegistrationWithThreadUniqueName();
+    } catch (const std::logic_error & ex) {
+        exceptionThrown = true;
+    }
+
+    ASSERT_TRUE(exceptionThrown);
+}
+
+TEST_F(RegistrarTests, getRegistration_GivenFrozenRegistrar_ReturnsFunctor)
+{
+    auto key = givenRegistrationWithThreadUniqueName();
+    auto expectedValue = getTid();
+    _subject.freeze();
+
+    auto & registration = _subject.getRegistration<std::string>(key);
+    auto result = registration.resolve<std::string>(_container);
+
+    ASSERT_EQ(expectedValue, result);
+}
+
+TEST_F(RegistrarTests, bind_GivenReaderInsideEpochGuard_KeepsReplacedRegistrationAlive)
+{
+    auto key = givenRegistrationWithThreadUniqueName();
+    auto expectedValue = getTid();
+    auto epoch = cdif::EpochGuard();
+    auto & previousRegistration = _subject.getRegistration<std::string>(key);
+
+    std::function<std::string (const cdif::Container&)> functor = [] (const cdif::Container &) { return std::string("Rebound"); };
+    _subject.bind(cdif::Registration(functor), key);
+
+    ASSERT_EQ(expectedValue, previousRegistration.resolve<std::string>(_container));
+    ASSERT_EQ("Rebound", _subject.getRegistration<std::string>(key).resolve<std::string>(_container));
+}
+
+TEST_F(RegistrarTests, bind_GivenNoReaderInsideEpochGuard_ModifiesPublishedTableInPlace)
+{
+    auto key = givenRegistrationWithThreadUniqueName();
+    auto* previousRegistration = &_subject.getRegistration<std::string>(key);
+
+    std::function<std::string (const cdif::Container&)> functor = [] (const cdif::Container &) { return std::string("Rebound"); };
+    _subject.bind(cdif::Registration(functor), key);
+    auto& registration = _subject.getRegistration<std::string>(key);
+
+    ASSERT_EQ(previousRegistration, &registration);
+    ASSERT_EQ("Rebound", registration.resolve<std::string>(_container));
+}
+
+TEST_F(RegistrarTests, reclaim_GivenNoReaderInsideEpochGuard_FreesReplacedRegistration)
+{
+    auto key = _serviceNameFactory.create<int>();
+    auto token = std::make_shared<int>(1);
+    std::weak_ptr<int> weakToken = token;
+    std::function<int (const cdif::Container&)> functor = [token] (const cdif::Container&) { return *token; };
+    _subject.bind(cdif::Registration(functor), key);
+    functor = nullptr;
+    token.reset();
+
+    {
+        auto epoch = cdif::EpochGuard();
+        _subject.getRegistration<int>(key);
+        std::function<int (const cdif::Container&)> rebound = [] (const cdif::Container&) { return 2; };
+        _subject.bind(cdif::Registration(rebound), key);
+        _subject.reclaim();
+        ASSERT_FALSE(weakToken.expired());
+    }
+    _subject.reclaim();
+
+    ASSERT_TRUE(weakToken.expired());
+}
+
+TEST_F(RegistrarTests, bind_GivenConcurrentReaders_ResolvesEitherRegistration)
+{
+    const auto threadCount = 4;
+    auto key = _serviceNameFactory.create<int>();
+    std::function<int (const cdif::Container&)> functor = [] (const cdif::Container&) { return 0; };
+    _subject.bind(cdif::Registration(functor), key);
+    auto done = std::atomic<bool>(false);
+    auto failures = std::atomic<int>(0);
+    auto reader = [&] () {
+        while (!done.load()) {
+            auto epoch = cdif::EpochGuard();
+            auto value = _subject.getRegistration<int>(key).resolve<int>(_container);
+            if (value < 0 || value > 1000)
+                failures++;
+        }
+    };
+
+    auto threads = std::vector<std::thread>();
+    for (auto i = 0; i < threadCount; i++)
+        threads.push_back(std::thread(reader));
+    for (auto i = 1; i <= 1000; i++) {
+        std::function<int (const cdif::Container&)> rebound = [i] (const cdif::Container&) { return i; };
+        _subject.bind(cdif::Registration(rebound), key);
+    }
+    done.store(true);
+    for (auto & t : threads)
+        t.join();
+
+    ASSERT_EQ(0, failures.load());
+    ASSERT_EQ(1000, _subject.getRegistration<int>(key).resolve<int>(_container));
+}
+
+TEST_F(RegistrarTests, Registrar_IsThreadSafeBetweenFrozenReads)
+{
+    const auto threadCount = 100;
+    auto key = givenRegistrationWithThreadUniqueName();
+    _subject.freeze();
+    auto functor = [&] (){
+        _subject.getRegistration<std::string>(key);
     };
 
     auto threads = std::vector<std::thread>();
@@ -82,3 +226,33 @@ TEST_F(RegistrarTests, Registrar_IsThreadSafeBetweenMultipleReadsAndWrites)
     for (auto & t : threads)
         t.join();
 }
+
+TEST_F(RegistrarTests, getRegistration_GivenCanonicalRegistration_DerivesVariant)
+{
+    _subject.bind(givenRegistrationWithVariants(7), _serviceNameFactory.create<int>());
+
+    auto key = _serviceNameFactory.create<std::shared_ptr<int>>();
+    auto& registration = _subject.getRegistration<std::shared_ptr<int>>(key);
+
+    ASSERT_EQ(7, *registration.resolve<std::shared_ptr<int>>(_container));
+    ASSERT_EQ(&registration, &_subject.getRegistration<std::shared_ptr<int>>(key));
+}
+
+TEST_F(RegistrarTests, getRegistration_GivenRegistrationBoundToVariantKey_PrefersIt)
+{
+    _subject.bind(givenRegistrationWithVariants(7), _serviceNameFactory.create<int>());
+    std::function<std::shared_ptr<int> (const cdif::Container&)> functor = [] (const cdif::Container&) { return std::make_shared<int>(3); };
+    auto key = _serviceNameFactory.create<std::shared_ptr<int>>();
+    _subject.bind(cdif::Registration(functor), key);
+
+    auto& registration = _subject.getRegistration<std::shared_ptr<int>>(key);
+
+    ASSERT_EQ(3, *registration.resolve<std::shared_ptr<int>>(_container));
+}
+
+TEST_F(RegistrarTests, getRegistration_GivenVariantThatCannotBeDerived_ThrowsException)
+{
+    _subject.bind(givenRegistrationWithVariants(7), _serviceNameFactory.create<int>());
+
+    ASSERT_THROW(_subject.getRegistration<std::unique_ptr<int>>(_serviceNameFactory.create<std::unique_ptr<int>>()), std::invalid_argument);
+}
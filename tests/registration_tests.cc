@@ -1,5 +1,6 @@
 #include <any>
 #include <functional>
+#include <typeinfo>
 
 #include <gtest/gtest.h>
 
@@ -28,3 +29,17 @@ TEST_F(RegistrationTests, Resolve_ProperlyCastsValueBackToOriginal)
 
     ASSERT_EQ(actual, _returnedValue) << "Value not properly casted to original";
 }
+
+TEST_F(RegistrationTests, Resolve_GivenMismatchedType_ThrowsException)
+{
+    auto subject = cdif::Registration(_resolver);
+    auto exceptionThrown = false;
+
+    try {
+        subject.resolve<int>(_container);
+    } catch (const std::bad_cast & ex) {
+        exceptionThrown = true;
+    }
+
+    ASSERT_TRUE(exceptionThrown);
+}
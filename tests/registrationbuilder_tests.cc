@@ -3,9 +3,71 @@
 
 #include <gtest/gtest.h>
 
+#include <atomic>
 #include <functional>
+#include <memory>
+#include <set>
 #include <string>
 #include <thread>
+#include <vector>
+
+class DestructionTracker
+{
+    private:
+        std::shared_ptr<bool> m_destroyed;
+
+    public:
+        DestructionTracker(std::shared_ptr<bool> destroyed) : m_destroyed(destroyed) {}
+        DestructionTracker(DestructionTracker&&) = default;
+
+        ~DestructionTracker()
+        {
+            if (m_destroyed)
+                *m_destroyed = true;
+        }
+};
+
+using DestructionLog = std::shared_ptr<std::vector<std::string>>;
+
+class LoggedDependency
+{
+    public:
+        DestructionLog m_log;
+        int m_data;
+
+        LoggedDependency(DestructionLog log, int data) : m_log(log), m_data(data) {}
+
+        ~LoggedDependency()
+        {
+            m_log->push_back("~LoggedDependency");
+        }
+};
+
+class LoggedDependent
+{
+    private:
+        DestructionLog m_log;
+        LoggedDependency& m_dependency;
+
+    public:
+        LoggedDependent(DestructionLog log, LoggedDependency& dependency) : m_log(log), m_dependency(dependency) {}
+
+        ~LoggedDependent()
+        {
+            m_log->push_back("~LoggedDependent sees " + std::to_string(m_dependency.m_data));
+        }
+};
+
+class Immovable
+{
+    public:
+        int m_data;
+
+        Immovable(int data) : m_data(data) {}
+
+        Immovable(const Immovable&) = delete;
+        Immovable& operator=(const Immovable&) = delete;
+};
 
 class RegistrationBuilderTests : public ::testing::Test
 {
@@ -91,14 +153,35 @@ TEST_F(RegistrationBuilderTests, Resolve_GivenSingletonRegistration_CanResolveSh
     ASSERT_NE(result.get(), nullptr);
 }
 
+TEST_F(RegistrationBuilderTests, Destructor_GivenSingletonUsingDependencyInDestructor_DestroysDependentFirst)
+{
+    auto log = std::make_shared<std::vector<std::string>>();
+    {
+        auto container = cdif::Container();
+        container.bind<DestructionLog>([log] () { return log; }).build();
+        container.bind<int>([] () { return 42; }).build();
+        container.bind<LoggedDependency, DestructionLog, int>().in<cdif::Scope::Singleton>().build();
+        container.bind<LoggedDependent, DestructionLog, LoggedDependency&>().in<cdif::Scope::Singleton>().build();
+        container.resolve<LoggedDependent&>();
+    }
+
+    ASSERT_EQ((std::vector<std::string> { "~LoggedDependent sees 42", "~LoggedDependency" }), *log);
+}
+
 TEST_F(RegistrationBuilderTests, Resolve_GivenPerThreadRegistration_ResolvesNewInstancePerThread)
 {
     NonCopyable* first = nullptr, * second = nullptr;
+    auto resolved = std::atomic<int>(0);
     givenRegistrationReturningValue(333);
     _subject.bind<NonCopyable, int>().in<cdif::Scope::PerThread>().build();
+    // Both threads live until both have resolved, so neither instance has
+    // been freed and had its address reused.
     auto functor = [&] (NonCopyable** ptr)
     {
         *ptr = _subject.resolve<NonCopyable*>();
+        resolved++;
+        while (resolved.load() < 2)
+            std::this_thread::yield();
     };
 
     auto t1 = std::thread(functor, &first);
@@ -137,3 +220,291 @@ TEST_F(RegistrationBuilderTests, Resolve_GivenRegistrationWithParameterFactory_R
     ASSERT_EQ(expectedValue, result.m_data);
 }
 
+TEST_F(RegistrationBuilderTests, Resolve_GivenParameterFactoryForLaterIndex_ResolvesRemainingParametersFromContainer) {
+    auto expectedValue = 324;
+    auto overriddenValue = 97;
+    givenRegistrationReturningValue(expectedValue);
+    _subject.bind<SimpleImplementation, int>().as<Interface>().build();
+    _subject.bind<ComplexImplementation, int, std::shared_ptr<Interface>, std::shared_ptr<Interface>>()
+        .withIndexedParameterFrom<2, std::shared_ptr<Interface>>([overriddenValue] (const cdif::Container&)
+            {
+                return std::make_shared<SimpleImplementation>(overriddenValue);
+            })
+        .build();
+
+    auto result = _subject.resolve<ComplexImplementation>();
+
+    ASSERT_EQ(expectedValue, result.m_data);
+    ASSERT_EQ(expectedValue, result.m_obj1->m_data);
+    ASSERT_EQ(overriddenValue, result.m_obj2->m_data);
+}
+
+TEST_F(RegistrationBuilderTests, Resolve_GivenSingletonRegistration_ResolvesSameInstanceForEveryVariant)
+{
+    givenRegistrationReturningValue(343);
+    _subject.bind<SimpleImplementation, int>().as<Interface>().in<cdif::Scope::Singleton>().build();
+
+    auto& reference = _subject.resolve<SimpleImplementation&>();
+    auto* pointer = _subject.resolve<Interface*>();
+    auto shared = _subject.resolve<std::shared_ptr<Interface>>();
+
+    ASSERT_EQ(static_cast<Interface*>(std::addressof(reference)), pointer);
+    ASSERT_EQ(pointer, shared.get());
+}
+
+TEST_F(RegistrationBuilderTests, Resolve_GivenSingletonRegistrationsInSeparateContainers_ResolvesInstancePerContainer)
+{
+    auto other = cdif::Container();
+    givenRegistrationReturningValue(343);
+    other.bind<int>([] () { return 343; }).build();
+    _subject.bind<SimpleImplementation, int>().in<cdif::Scope::Singleton>().build();
+    other.bind<SimpleImplementation, int>().in<cdif::Scope::Singleton>().build();
+
+    auto* a = _subject.resolve<SimpleImplementation*>();
+    auto* b = other.resolve<SimpleImplementation*>();
+
+    ASSERT_NE(a, b);
+}
+
+TEST_F(RegistrationBuilderTests, Resolve_GivenNamedSingletonRegistrations_ResolvesInstancePerName)
+{
+    givenRegistrationReturningValue(343);
+    _subject.bind<SimpleImplementation, int>().named("First").in<cdif::Scope::Singleton>().build();
+    _subject.bind<SimpleImplementation, int>().named("Second").in<cdif::Scope::Singleton>().build();
+
+    auto* a = _subject.resolve<SimpleImplementation*>("First");
+    auto* b = _subject.resolve<SimpleImplementation*>("Second");
+
+    ASSERT_NE(a, b);
+    ASSERT_EQ(a, _subject.resolve<SimpleImplementation*>("First"));
+}
+
+TEST_F(RegistrationBuilderTests, Resolve_GivenSingletonFactoryRegistration_ResolvesSameInstancePerCall)
+{
+    _subject.bind<SimpleImplementation, int>([] (int value) { return SimpleImplementation(value); })
+        .in<cdif::Scope::Singleton>()
+        .build();
+
+    auto* a = _subject.resolve<std::function<SimpleImplementation* (int)>>()(1);
+    auto& b = _subject.resolve<std::function<SimpleImplementation& (int)>>()(2);
+
+    ASSERT_EQ(a, std::addressof(b));
+    ASSERT_EQ(1, b.m_data);
+}
+
+TEST_F(RegistrationBuilderTests, Resolve_GivenSingletonRegistrationResolvedFromManyThreads_ConstructsOneInstance)
+{
+    const auto threadCount = 16;
+    givenRegistrationReturningValue(343);
+    _subject.bind<SimpleImplementation, int>().in<cdif::Scope::Singleton>().build();
+    auto instances = std::vector<SimpleImplementation*>(threadCount);
+    auto threads = std::vector<std::thread>();
+
+    for (auto i = 0; i < threadCount; i++)
+        threads.push_back(std::thread([&, i] () { instances[static_cast<size_t>(i)] = _subject.resolve<SimpleImplementation*>(); }));
+    for (auto & t : threads)
+        t.join();
+
+    for (auto* instance : instances)
+        ASSERT_EQ(instances.front(), instance);
+}
+
+TEST_F(RegistrationBuilderTests, Resolve_GivenSingletonRegistration_ReleasesInstanceWithContainer)
+{
+    auto destroyed = std::make_shared<bool>(false);
+    {
+        auto ctx = cdif::Container();
+        ctx.bind<std::shared_ptr<bool>>([destroyed] () { return destroyed; }).build();
+        ctx.bind<DestructionTracker, std::shared_ptr<bool>>().in<cdif::Scope::Singleton>().build();
+        ctx.resolve<DestructionTracker&>();
+
+        ASSERT_FALSE(*destroyed);
+    }
+
+    ASSERT_TRUE(*destroyed);
+}
+
+TEST_F(RegistrationBuilderTests, Resolve_GivenSingletonSharedPtr_SharesOwnershipOfInstance)
+{
+    givenRegistrationReturningValue(343);
+    _subject.bind<SimpleImplementation, int>().as<Interface>().in<cdif::Scope::Singleton>().build();
+
+    auto first = _subject.resolve<std::shared_ptr<Interface>>();
+    auto second = _subject.resolve<std::shared_ptr<Interface>>();
+
+    ASSERT_EQ(first, second);
+    ASSERT_EQ(&_subject.resolve<Interface&>(), first.get());
+    ASSERT_FALSE(first.owner_before(second) || second.owner_before(first));
+}
+
+TEST_F(RegistrationBuilderTests, Resolve_GivenSingletonSharedPtr_KeepsInstanceAfterContainer)
+{
+    auto destroyed = std::make_shared<bool>(false);
+    auto instance = std::shared_ptr<DestructionTracker>();
+    {
+        auto ctx = cdif::Container();
+        ctx.bind<std::shared_ptr<bool>>([destroyed] () { return destroyed; }).build();
+        ctx.bind<DestructionTracker, std::shared_ptr<bool>>().in<cdif::Scope::Singleton>().build();
+        instance = ctx.resolve<std::shared_ptr<DestructionTracker>>();
+    }
+
+    ASSERT_FALSE(*destroyed);
+    instance.reset();
+    ASSERT_TRUE(*destroyed);
+}
+
+TEST_F(RegistrationBuilderTests, Resolve_GivenImmovablePerThreadType_ResolvesInstanceBuiltInPlace)
+{
+    auto expectedValue = 41;
+    givenRegistrationReturningValue(expectedValue);
+    _subject.bind<Immovable, int>().in<cdif::Scope::PerThread>().build();
+
+    auto& result = _subject.resolve<Immovable&>();
+
+    ASSERT_EQ(expectedValue, result.m_data);
+    ASSERT_EQ(&result, _subject.resolve<Immovable*>());
+}
+
+TEST_F(RegistrationBuilderTests, Resolve_GivenPerThreadRegistrationsInSeparateContainers_ResolvesInstancePerContainer)
+{
+    auto other = cdif::Container();
+    givenRegistrationReturningValue(343);
+    other.bind<int>([] () { return 343; }).build();
+    _subject.bind<SimpleImplementation, int>().in<cdif::Scope::PerThread>().build();
+    other.bind<SimpleImplementation, int>().in<cdif::Scope::PerThread>().build();
+
+    auto* a = _subject.resolve<SimpleImplementation*>();
+    auto* b = other.resolve<SimpleImplementation*>();
+
+    ASSERT_NE(a, b);
+    ASSERT_EQ(a, _subject.resolve<SimpleImplementation*>());
+}
+
+TEST_F(RegistrationBuilderTests, Resolve_GivenNamedPerThreadRegistrations_ResolvesInstancePerName)
+{
+    givenRegistrationReturningValue(343);
+    _subject.bind<SimpleImplementation, int>().named("First").in<cdif::Scope::PerThread>().build();
+    _subject.bind<SimpleImplementation, int>().named("Second").in<cdif::Scope::PerThread>().build();
+
+    auto* a = _subject.resolve<SimpleImplementation*>("First");
+    auto* b = _subject.resolve<SimpleImplementation*>("Second");
+
+    ASSERT_NE(a, b);
+    ASSERT_EQ(a, _subject.resolve<SimpleImplementation*>("First"));
+}
+
+TEST_F(RegistrationBuilderTests, Resolve_GivenAlternatingPerThreadRegistrations_ResolvesInstancePerName)
+{
+    auto names = std::vector<std::string> { "", "First", "Second", "Third", "Fourth", "Fifth" };
+    givenRegistrationReturningValue(343);
+    for (auto& name : names)
+        _subject.bind<SimpleImplementation, int>().named(name).in<cdif::Scope::PerThread>().build();
+
+    auto first = std::vector<SimpleImplementation*>();
+    for (auto& name : names)
+        first.push_back(_subject.resolve<SimpleImplementation*>(name));
+
+    for (auto i = 0; i < 3; i++)
+        for (size_t j = 0; j < names.size(); j++)
+            ASSERT_EQ(first[j], _subject.resolve<SimpleImplementation*>(names[j]));
+    ASSERT_EQ(names.size(), std::set<SimpleImplementation*>(first.begin(), first.end()).size());
+}
+
+TEST_F(RegistrationBuilderTests, Resolve_GivenPerThreadRegistration_ReleasesInstanceWhenThreadExits)
+{
+    auto destroyed = std::make_shared<bool>(false);
+    _subject.bind<std::shared_ptr<bool>>([destroyed] () { return destroyed; }).build();
+    _subject.bind<DestructionTracker, std::shared_ptr<bool>>().in<cdif::Scope::PerThread>().build();
+
+    auto t = std::thread([&] () { _subject.resolve<DestructionTracker&>(); });
+    t.join();
+
+    ASSERT_TRUE(*destroyed);
+}
+
+TEST_F(RegistrationBuilderTests, ReleaseThread_GivenPerThreadInstance_DestroysInstance)
+{
+    auto destroyed = std::make_shared<bool>(false);
+    _subject.bind<std::shared_ptr<bool>>([destroyed] () { return destroyed; }).build();
+    _subject.bind<DestructionTracker, std::shared_ptr<bool>>().in<cdif::Scope::PerThread>().build();
+    _subject.resolve<DestructionTracker&>();
+
+    _subject.releaseThread();
+
+    ASSERT_TRUE(*destroyed);
+}
+
+TEST_F(RegistrationBuilderTests, ReleaseThread_GivenHeldSharedPtr_KeepsInstanceUntilReleased)
+{
+    auto destroyed = std::make_shared<bool>(false);
+    _subject.bind<std::shared_ptr<bool>>([destroyed] () { return destroyed; }).build();
+    _subject.bind<DestructionTracker, std::shared_ptr<bool>>().in<cdif::Scope::PerThread>().build();
+    auto instance = _subject.resolve<std::shared_ptr<DestructionTracker>>();
+
+    _subject.releaseThread();
+
+    ASSERT_FALSE(*destroyed);
+    ASSERT_NE(instance, _subject.resolve<std::shared_ptr<DestructionTracker>>());
+    instance.reset();
+    ASSERT_TRUE(*destroyed);
+}
+
+TEST_F(RegistrationBuilderTests, ReleaseThread_GivenOtherThread_KeepsInstanceOfCurrentThread)
+{
+    auto destroyed = std::make_shared<bool>(false);
+    _subject.bind<std::shared_ptr<bool>>([destroyed] () { return destroyed; }).build();
+    _subject.bind<DestructionTracker, std::shared_ptr<bool>>().in<cdif::Scope::PerThread>().build();
+    auto* instance = _subject.resolve<DestructionTracker*>();
+    auto t = std::thread([] () {});
+    auto otherThread = t.get_id();
+    t.join();
+
+    _subject.releaseThread(otherThread);
+
+    ASSERT_FALSE(*destroyed);
+    ASSERT_EQ(instance, _subject.resolve<DestructionTracker*>());
+}
+
+TEST_F(RegistrationBuilderTests, ReleaseAllThreads_GivenPerThreadInstance_BuildsNewInstanceOnNextResolve)
+{
+    auto destroyed = std::make_shared<bool>(false);
+    auto built = 0;
+    _subject.bind<std::shared_ptr<bool>>([destroyed, &built] () { built++; return destroyed; }).build();
+    _subject.bind<DestructionTracker, std::shared_ptr<bool>>().in<cdif::Scope::PerThread>().build();
+    _subject.resolve<DestructionTracker&>();
+
+    _subject.releaseAllThreads();
+    _subject.resolve<DestructionTracker&>();
+
+    ASSERT_TRUE(*destroyed);
+    ASSERT_EQ(2, built);
+}
+
+TEST_F(RegistrationBuilderTests, ReleaseThread_GivenRepeatedReleases_TracksStorageOnceForThread)
+{
+    givenRegistrationReturningValue(3);
+    _subject.bind<SimpleImplementation, int>().in<cdif::Scope::PerThread>().build();
+    _subject.resolve<SimpleImplementation&>();
+    auto tracked = cdif::detail::ThreadExitCleanup::forThisThread().size();
+
+    for (auto i = 0; i < 100; i++) {
+        _subject.releaseThread();
+        _subject.resolve<SimpleImplementation&>();
+    }
+
+    ASSERT_EQ(tracked, cdif::detail::ThreadExitCleanup::forThisThread().size());
+}
+
+TEST_F(RegistrationBuilderTests, ReleaseThread_GivenPerThreadFactoryRegistration_DestroysInstance)
+{
+    auto destroyed = std::make_shared<bool>(false);
+    _subject.bind<DestructionTracker, std::shared_ptr<bool>>(
+            [] (std::shared_ptr<bool> flag) { return DestructionTracker(flag); })
+        .in<cdif::Scope::PerThread>()
+        .build();
+    _subject.resolve<std::function<DestructionTracker& (std::shared_ptr<bool>)>>()(destroyed);
+
+    _subject.releaseThread();
+
+    ASSERT_TRUE(*destroyed);
+}
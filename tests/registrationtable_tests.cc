@@ -0,0 +1,98 @@
+#include <functional>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "cdif.h"
+
+class RegistrationTableTests : public ::testing::Test
+{
+    protected:
+        cdif::RegistrationTable _subject;
+        cdif::Container _container;
+
+        cdif::Registration givenRegistrationReturningValue(size_t value)
+        {
+            std::function<size_t (const cdif::Container&)> resolver = [value] (const cdif::Container&) { return value; };
+            return cdif::Registration(resolver);
+        }
+
+        cdif::ServiceKey keyFor(size_t name)
+        {
+            return cdif::ServiceKey { cdif::type_key<size_t>, name };
+        }
+};
+
+TEST_F(RegistrationTableTests, Find_GivenNoMatch_ReturnsNull)
+{
+    _subject.insert_or_assign(keyFor(1), givenRegistrationReturningValue(1));
+
+    auto* result = _subject.find(keyFor(2));
+
+    ASSERT_EQ(nullptr, result);
+}
+
+TEST_F(RegistrationTableTests, Find_GivenMatchingKey_ReturnsRegistration)
+{
+    auto expectedValue = 42u;
+    _subject.insert_or_assign(keyFor(1), givenRegistrationReturningValue(expectedValue));
+
+    auto* result = _subject.find(keyFor(1));
+
+    ASSERT_EQ(expectedValue, result->resolve<size_t>(_container));
+}
+
+TEST_F(RegistrationTableTests, InsertOrAssign_GivenExistingKey_ReplacesRegistration)
+{
+    auto expectedValue = 7u;
+    _subject.insert_or_assign(keyFor(1), givenRegistrationReturningValue(3));
+    _subject.insert_or_assign(keyFor(1), givenRegistrationReturningValue(expectedValue));
+
+    auto* result = _subject.find(keyFor(1));
+
+    ASSERT_EQ(1u, _subject.size());
+    ASSERT_EQ(expectedValue, result->resolve<size_t>(_container));
+}
+
+TEST_F(RegistrationTableTests, InsertOrAssign_GivenManyKeys_AllKeysRemainReachable)
+{
+    const size_t count = 10000;
+    for (size_t i = 0; i < count; i++)
+        _subject.insert_or_assign(keyFor(i), givenRegistrationReturningValue(i));
+
+    ASSERT_EQ(count, _subject.size());
+    for (size_t i = 0; i < count; i++)
+        ASSERT_EQ(i, _subject.find(keyFor(i))->resolve<size_t>(_container));
+}
+
+TEST_F(RegistrationTableTests, InsertOrAssign_WhenTableGrows_DoesNotMoveExistingRegistrations)
+{
+    _subject.insert_or_assign(keyFor(0), givenRegistrationReturningValue(0));
+    auto* expected = _subject.find(keyFor(0));
+
+    for (size_t i = 1; i < 1000; i++)
+        _subject.insert_or_assign(keyFor(i), givenRegistrationReturningValue(i));
+
+    ASSERT_EQ(expected, _subject.find(keyFor(0)));
+}
+
+TEST_F(RegistrationTableTests, Erase_GivenErasedKeys_OtherKeysRemainReachable)
+{
+    const size_t count = 1000;
+    for (size_t i = 0; i < count; i++)
+        _subject.insert_or_assign(keyFor(i), givenRegistrationReturningValue(i));
+
+    for (size_t i = 0; i < count; i += 2)
+        ASSERT_TRUE(_subject.erase(keyFor(i)));
+    for (size_t i = count; i < 2 * count; i++)
+        _subject.insert_or_assign(keyFor(i), givenRegistrationReturningValue(i));
+
+    ASSERT_EQ(count / 2 + count, _subject.size());
+    for (size_t i = 0; i < 2 * count; i++) {
+        auto* result = _subject.find(keyFor(i));
+        if (i < count && i % 2 == 0)
+            ASSERT_EQ(nullptr, result);
+        else
+            ASSERT_EQ(i, result->resolve<size_t>(_container));
+    }
+}
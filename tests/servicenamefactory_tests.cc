@@ -0,0 +1,90 @@
+#include <string>
+
+#include <gtest/gtest.h>
+
+#include "cdif.h"
+
+class ServiceNameFactoryTests : public ::testing::Test
+{
+    protected:
+        cdif::ServiceNameFactory _subject;
+};
+
+TEST_F(ServiceNameFactoryTests, Create_GivenSameTypeAndName_ReturnsEqualKeys)
+{
+    auto first = _subject.create<int>("Name");
+    auto second = _subject.create<int>("Name");
+
+    ASSERT_EQ(first, second);
+}
+
+TEST_F(ServiceNameFactoryTests, Create_GivenDifferentTypes_ReturnsDifferentKeys)
+{
+    auto first = _subject.create<int>();
+    auto second = _subject.create<long>();
+
+    ASSERT_NE(first, second);
+}
+
+TEST_F(ServiceNameFactoryTests, Create_GivenDifferentNames_ReturnsDifferentKeys)
+{
+    auto first = _subject.create<int>("First");
+    auto second = _subject.create<int>("Second");
+
+    ASSERT_NE(first, second);
+}
+
+TEST_F(ServiceNameFactoryTests, Create_GivenEmptyName_ReturnsUnnamedKey)
+{
+    auto named = _subject.create<int>(std::string());
+    auto unnamed = _subject.create<int>();
+
+    ASSERT_EQ(named, unnamed);
+}
+
+TEST_F(ServiceNameFactoryTests, Find_GivenInternedName_ReturnsCreatedKey)
+{
+    auto expected = _subject.create<int>("Name");
+
+    auto result = _subject.find<int>("Name");
+
+    ASSERT_EQ(expected, result);
+}
+
+TEST_F(ServiceNameFactoryTests, Find_GivenUnknownName_ReturnsUnknownNameKey)
+{
+    auto result = _subject.find<int>("Unknown");
+
+    ASSERT_EQ(cdif::ServiceNameFactory::UnknownName, result.name);
+}
+
+TEST_F(ServiceNameFactoryTests, Find_GivenPublishedName_ReturnsCreatedKey)
+{
+    auto expected = _subject.create<int>("Name");
+    _subject.publish();
+
+    auto result = _subject.find<int>("Name");
+
+    ASSERT_EQ(expected, result);
+}
+
+TEST_F(ServiceNameFactoryTests, Find_GivenNameCreatedAfterPublish_ReturnsCreatedKey)
+{
+    _subject.create<int>("First");
+    _subject.publish();
+    auto expected = _subject.create<int>("Second");
+
+    auto result = _subject.find<int>("Second");
+
+    ASSERT_EQ(expected, result);
+}
+
+TEST_F(ServiceNameFactoryTests, Find_GivenUnknownNameAfterPublish_ReturnsUnknownNameKey)
+{
+    _subject.create<int>("Name");
+    _subject.publish();
+
+    auto result = _subject.find<int>("Unknown");
+
+    ASSERT_EQ(cdif::ServiceNameFactory::UnknownName, result.name);
+}
@@ -0,0 +1,166 @@
+#include <array>
+#include <list>
+#include <memory>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "cdif.h"
+#include "test_types.h"
+
+namespace {
+    int value() { return 42; }
+
+    struct Primary;
+    struct Secondary;
+
+    int primaryValue() { return 1; }
+    int secondaryValue() { return 2; }
+
+    struct Pair
+    {
+        int m_first;
+        int m_second;
+
+        Pair(int first, int second) : m_first(first), m_second(second) {}
+    };
+
+    struct Pinned
+    {
+        int m_value;
+
+        Pinned(int data) : m_value(data) {}
+
+        Pinned(const Pinned&) = delete;
+        Pinned& operator=(const Pinned&) = delete;
+    };
+
+    struct Cyclic
+    {
+        Cyclic(std::shared_ptr<Cyclic>) {}
+    };
+}
+
+using TypeContainer = cdif::StaticContainer<
+    cdif::BindFactory<&value>,
+    cdif::Bind<SimpleImplementation, int>::as<Interface>,
+    cdif::Bind<ComplexImplementation, int, std::shared_ptr<Interface>, std::shared_ptr<Interface>>>;
+
+using SingletonContainer = cdif::StaticContainer<
+    cdif::BindFactory<&value>,
+    cdif::Bind<SimpleImplementation, int>::as<Interface>::in<cdif::Scope::Singleton>,
+    cdif::Bind<Pinned, int>::in<cdif::Scope::Singleton>>;
+
+using NamedContainer = cdif::StaticContainer<
+    cdif::BindFactory<&primaryValue>::named<Primary>,
+    cdif::BindFactory<&secondaryValue>::named<Secondary>,
+    cdif::Bind<Pair, cdif::Named<int, Secondary>, cdif::Named<int, Primary>>>;
+
+using ListContainer = cdif::StaticContainer<
+    cdif::BindFactory<&value>,
+    cdif::Bind<SimpleImplementation, int>,
+    cdif::BindList<std::shared_ptr<Interface>, std::shared_ptr<SimpleImplementation>, std::unique_ptr<SimpleImplementation>>>;
+
+static_assert(TypeContainer::can_resolve<std::shared_ptr<Interface>>);
+static_assert(!TypeContainer::can_resolve<std::shared_ptr<UniqueImplementationDecorator>>);
+static_assert(!cdif::StaticBindings<cdif::Bind<SimpleImplementation, int>>::is_complete);
+static_assert(!cdif::StaticBindings<
+    cdif::BindFactory<&value>,
+    cdif::BindFactory<&primaryValue>,
+    cdif::Bind<SimpleImplementation, int>>::is_complete);
+static_assert(!cdif::StaticBindings<cdif::Bind<Cyclic, std::shared_ptr<Cyclic>>>::is_acyclic);
+static_assert(!cdif::StaticBindings<
+    cdif::BindFactory<&value>,
+    cdif::Bind<SharedImplementationDecorator, int, std::shared_ptr<Interface>>::as<Interface>>::is_acyclic);
+
+TEST(StaticContainerTests, Resolve_GivenTypeBinding_ResolvesEachForm)
+{
+    auto subject = TypeContainer();
+
+    auto result = subject.resolve<SimpleImplementation>();
+    auto shared = subject.resolve<std::shared_ptr<Interface>>();
+    auto unique = subject.resolve<std::unique_ptr<Interface>>();
+    auto raw = std::unique_ptr<Interface>(subject.resolve<Interface*>());
+
+    ASSERT_EQ(42, result.m_data);
+    ASSERT_EQ(42, shared->m_data);
+    ASSERT_EQ(42, unique->m_data);
+    ASSERT_EQ(42, raw->m_data);
+}
+
+TEST(StaticContainerTests, Resolve_GivenPerDependencyBinding_ResolvesNewInstanceEachTime)
+{
+    auto subject = TypeContainer();
+
+    auto result = subject.resolve<std::shared_ptr<ComplexImplementation>>();
+
+    ASSERT_EQ(42, result->m_obj1->m_data);
+    ASSERT_NE(result->m_obj1, result->m_obj2);
+}
+
+TEST(StaticContainerTests, Resolve_GivenSingletonBinding_ResolvesMemberInstance)
+{
+    auto subject = SingletonContainer();
+
+    auto& reference = subject.resolve<Interface&>();
+    auto* pointer = subject.resolve<SimpleImplementation*>();
+    auto shared = subject.resolve<std::shared_ptr<Interface>>();
+
+    ASSERT_EQ(&reference, pointer);
+    ASSERT_EQ(pointer, shared.get());
+    ASSERT_EQ(42, reference.m_data);
+}
+
+TEST(StaticContainerTests, Resolve_GivenSharedPtrToSingleton_PointsAtMemberInstance)
+{
+    auto subject = SingletonContainer();
+
+    auto shared = subject.resolve<std::shared_ptr<Interface>>();
+    auto& reference = subject.resolve<Interface&>();
+
+    ASSERT_EQ(&reference, shared.get());
+    ASSERT_EQ(shared, subject.resolve<std::shared_ptr<Interface>>());
+    ASSERT_EQ(42, shared->m_data);
+}
+
+TEST(StaticContainerTests, Resolve_GivenConstContainer_ResolvesEveryScope)
+{
+    const auto subject = SingletonContainer();
+
+    auto& reference = subject.resolve<Interface&>();
+    auto value = subject.resolve<int>();
+
+    ASSERT_EQ(&reference, subject.resolve<SimpleImplementation*>());
+    ASSERT_EQ(42, value);
+}
+
+TEST(StaticContainerTests, Resolve_GivenNonCopyableSingleton_ConstructsInPlace)
+{
+    auto subject = SingletonContainer();
+
+    ASSERT_EQ(42, subject.resolve<Pinned&>().m_value);
+}
+
+TEST(StaticContainerTests, Resolve_GivenNamedDependencies_ResolvesEachFromItsBinding)
+{
+    auto subject = NamedContainer();
+
+    auto result = subject.resolve<Pair>();
+
+    ASSERT_EQ(2, result.m_first);
+    ASSERT_EQ(1, result.m_second);
+    ASSERT_EQ(1, (subject.resolve<int, Primary>()));
+}
+
+TEST(StaticContainerTests, Resolve_GivenListBinding_ResolvesEachListType)
+{
+    auto subject = ListContainer();
+
+    auto vector = subject.resolve<std::vector<std::shared_ptr<Interface>>>();
+    auto list = subject.resolve<std::list<std::shared_ptr<Interface>>>();
+    auto array = subject.resolve<std::array<std::shared_ptr<Interface>, 2>>();
+
+    ASSERT_EQ(2u, vector.size());
+    ASSERT_EQ(2u, list.size());
+    ASSERT_EQ(42, array[1]->m_data);
+}
@@ -1,6 +1,8 @@
 #pragma once
 
+#include <cstddef>
 #include <memory>
+#include <memory_resource>
 
 class Interface {
     protected:
@@ -82,11 +84,10 @@ class UniqueImplementationDecorator : public Interface {
 };
 
 class ComplexImplementation : public Interface {
-    private:
+    public:
         std::shared_ptr<Interface> m_obj1;
         std::shared_ptr<Interface> m_obj2;
 
-    public:
         ComplexImplementation(int data, std::shared_ptr<Interface> obj1, std::shared_ptr<Interface> obj2)
             : Interface(data), m_obj1(obj1), m_obj2(obj2) {};
         ~ComplexImplementation() = default;
@@ -99,3 +100,31 @@ class ComplexImplementation : public Interface {
 
         void DoThings() {};
 };
+
+class CountingMemoryResource : public std::pmr::memory_resource
+{
+    private:
+        std::pmr::memory_resource* m_upstream = std::pmr::new_delete_resource();
+
+    protected:
+        void* do_allocate(size_t bytes, size_t alignment) override
+        {
+            allocations++;
+            return m_upstream->allocate(bytes, alignment);
+        }
+
+        void do_deallocate(void* p, size_t bytes, size_t alignment) override
+        {
+            deallocations++;
+            m_upstream->deallocate(p, bytes, alignment);
+        }
+
+        bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override
+        {
+            return this == &other;
+        }
+
+    public:
+        size_t allocations = 0;
+        size_t deallocations = 0;
+};
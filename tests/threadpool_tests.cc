@@ -0,0 +1,65 @@
+#include <atomic>
+#include <mutex>
+#include <set>
+#include <thread>
+
+#include <gtest/gtest.h>
+
+#include "cdif.h"
+
+class WorkStealingThreadPoolTests : public ::testing::Test
+{
+};
+
+TEST_F(WorkStealingThreadPoolTests, Constructor_GivenZeroThreads_StartsOneWorker)
+{
+    auto subject = cdif::WorkStealingThreadPool(0);
+
+    ASSERT_EQ(1u, subject.size());
+}
+
+TEST_F(WorkStealingThreadPoolTests, Wait_GivenSubmittedTasks_RunsEveryTask)
+{
+    auto subject = cdif::WorkStealingThreadPool(4);
+    auto count = std::atomic<int>(0);
+
+    for (int i = 0; i < 1000; i++)
+        subject.submit([&count] () { count++; });
+    subject.wait();
+
+    ASSERT_EQ(1000, count.load());
+}
+
+TEST_F(WorkStealingThreadPoolTests, Wait_GivenTasksSubmittingTasks_WaitsForNestedTasks)
+{
+    auto subject = cdif::WorkStealingThreadPool(2);
+    auto count = std::atomic<int>(0);
+
+    for (int i = 0; i < 10; i++)
+        subject.submit([&subject, &count] ()
+            {
+                for (int j = 0; j < 10; j++)
+                    subject.submit([&count] () { count++; });
+            });
+    subject.wait();
+
+    ASSERT_EQ(100, count.load());
+}
+
+TEST_F(WorkStealingThreadPoolTests, Submit_RunsTasksOnWorkerThreads)
+{
+    auto subject = cdif::WorkStealingThreadPool(2);
+    auto mutex = std::mutex();
+    auto threads = std::set<std::thread::id>();
+
+    for (int i = 0; i < 100; i++)
+        subject.submit([&] ()
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                threads.insert(std::this_thread::get_id());
+            });
+    subject.wait();
+
+    ASSERT_EQ(0u, threads.count(std::this_thread::get_id()));
+    ASSERT_LE(threads.size(), 2u);
+}
@@ -100,3 +100,59 @@ TEST_F(TypeRegistrationBuilderTests, Resolve_GivenTypeRegistration_CanResolveFac
 
     ASSERT_EQ(expectedValue, result.m_data);
 }
+
+TEST_F(TypeRegistrationBuilderTests, Resolve_GivenContainerMemoryResource_AllocatesSharedPtrFromResource)
+{
+    auto resource = CountingMemoryResource();
+    givenRegistrationReturningValue(352);
+    _subject.setMemoryResource(&resource);
+    _subject.bind<SimpleImplementation, int>().build();
+
+    {
+        auto result = _subject.resolve<std::shared_ptr<SimpleImplementation>>();
+
+        ASSERT_EQ(352, result->m_data);
+        ASSERT_EQ(1u, resource.allocations);
+    }
+
+    ASSERT_EQ(1u, resource.deallocations);
+}
+
+TEST_F(TypeRegistrationBuilderTests, Resolve_GivenRegistrationMemoryResource_AllocatesPmrUniquePtrFromResource)
+{
+    auto resource = CountingMemoryResource();
+    givenRegistrationReturningValue(352);
+    _subject.bind<SimpleImplementation, int>().withMemoryResource(&resource).build();
+
+    {
+        auto result = _subject.resolve<cdif::pmr_unique_ptr<SimpleImplementation>>();
+
+        ASSERT_EQ(352, result->m_data);
+        ASSERT_EQ(&resource, result.get_deleter().resource());
+        ASSERT_EQ(1u, resource.allocations);
+    }
+
+    ASSERT_EQ(1u, resource.deallocations);
+}
+
+TEST_F(TypeRegistrationBuilderTests, Resolve_GivenNoMemoryResource_AllocatesPmrUniquePtrFromDefaultResource)
+{
+    givenRegistrationReturningValue(352);
+    _subject.bind<SimpleImplementation, int>().build();
+
+    auto result = _subject.resolve<cdif::pmr_unique_ptr<SimpleImplementation>>();
+
+    ASSERT_EQ(std::pmr::get_default_resource(), result.get_deleter().resource());
+}
+
+TEST_F(TypeRegistrationBuilderTests, Resolve_GivenMemoryResourceSetAfterBind_DoesNotUseResource)
+{
+    auto resource = CountingMemoryResource();
+    givenRegistrationReturningValue(352);
+    _subject.bind<SimpleImplementation, int>().build();
+    _subject.setMemoryResource(&resource);
+
+    _subject.resolve<std::shared_ptr<SimpleImplementation>>();
+
+    ASSERT_EQ(0u, resource.allocations);
+}
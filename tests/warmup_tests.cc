@@ -0,0 +1,292 @@
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "cdif.h"
+
+namespace {
+    class BuildLog
+    {
+        private:
+            static std::mutex s_mutex;
+            static std::vector<std::string> s_entries;
+
+        public:
+            static void record(const std::string& entry)
+            {
+                std::lock_guard<std::mutex> lock(s_mutex);
+                s_entries.push_back(entry);
+            }
+
+            static std::vector<std::string> entries()
+            {
+                std::lock_guard<std::mutex> lock(s_mutex);
+                return s_entries;
+            }
+
+            static size_t positionOf(const std::string& entry)
+            {
+                auto log = entries();
+                return static_cast<size_t>(std::find(log.begin(), log.end(), entry) - log.begin());
+            }
+
+            static void clear()
+            {
+                std::lock_guard<std::mutex> lock(s_mutex);
+                s_entries.clear();
+            }
+    };
+
+    std::mutex BuildLog::s_mutex;
+    std::vector<std::string> BuildLog::s_entries;
+
+    template <int Id>
+    struct Service
+    {
+        Service() { BuildLog::record("Service" + std::to_string(Id)); }
+    };
+
+    struct Middle
+    {
+        std::shared_ptr<Service<1>> m_service;
+
+        Middle(std::shared_ptr<Service<1>> service) : m_service(service) { BuildLog::record("Middle"); }
+    };
+
+    struct Top
+    {
+        Middle m_middle;
+
+        Top(Middle middle) : m_middle(middle) { BuildLog::record("Top"); }
+    };
+
+    struct Failing
+    {
+        Failing() { throw std::runtime_error("failed to build"); }
+    };
+
+    struct CycleB;
+
+    struct CycleA
+    {
+        CycleA(CycleB&) { BuildLog::record("CycleA"); }
+    };
+
+    struct CycleB
+    {
+        CycleB(CycleA&) { BuildLog::record("CycleB"); }
+    };
+
+    struct DependsOnFailing
+    {
+        DependsOnFailing(Failing&) { BuildLog::record("DependsOnFailing"); }
+    };
+
+    // Each waits for the other to start building, so they only both finish
+    // when they are built at the same time.
+    std::atomic<int> s_started;
+
+    template <int Id>
+    struct Rendezvous
+    {
+        bool m_metOther;
+
+        Rendezvous() : m_metOther(false)
+        {
+            s_started++;
+            auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+            while (!m_metOther && std::chrono::steady_clock::now() < deadline)
+                m_metOther = s_started.load() >= 2;
+        }
+    };
+
+    struct FanOut
+    {
+        bool m_concurrent;
+
+        FanOut(Rendezvous<0>& first, Rendezvous<1>& second) : m_concurrent(first.m_metOther && second.m_metOther) {}
+    };
+}
+
+class WarmupTests : public ::testing::Test
+{
+    protected:
+        cdif::Container _subject;
+
+        void SetUp() override
+        {
+            BuildLog::clear();
+        }
+};
+
+TEST_F(WarmupTests, Warmup_GivenNoSingletons_BuildsNothing)
+{
+    _subject.bind<Service<0>>().build();
+
+    auto timings = _subject.warmup(2);
+
+    ASSERT_TRUE(timings.empty());
+    ASSERT_TRUE(BuildLog::entries().empty());
+}
+
+TEST_F(WarmupTests, Warmup_GivenSingleton_BuildsItBeforeFirstResolve)
+{
+    _subject.bind<Service<0>>().in<cdif::Scope::Singleton>().build();
+
+    _subject.warmup(2);
+    ASSERT_EQ(std::vector<std::string>({ "Service0" }), BuildLog::entries());
+
+    _subject.resolve<Service<0>&>();
+    ASSERT_EQ(1u, BuildLog::entries().size());
+}
+
+TEST_F(WarmupTests, Warmup_GivenSingletonBoundAsSeveralTypes_ReportsOneTiming)
+{
+    _subject.bind<Service<0>>().in<cdif::Scope::Singleton>().build();
+
+    auto timings = _subject.warmup(2);
+
+    ASSERT_EQ(1u, timings.size());
+    ASSERT_EQ(typeid(Service<0>).name(), timings[0].typeName);
+}
+
+TEST_F(WarmupTests, Warmup_GivenNamedSingleton_ReportsName)
+{
+    _subject.bind<Service<0>>().named("first").in<cdif::Scope::Singleton>().build();
+
+    auto timings = _subject.warmup(1);
+
+    ASSERT_EQ(1u, timings.size());
+    ASSERT_EQ("first", timings[0].name);
+}
+
+TEST_F(WarmupTests, Warmup_GivenSingletonDependingOnSingletonThroughPerDependency_BuildsDependencyFirst)
+{
+    _subject.bind<Top, Middle>().in<cdif::Scope::Singleton>().build();
+    _subject.bind<Middle, std::shared_ptr<Service<1>>>().build();
+    _subject.bind<Service<1>>().in<cdif::Scope::Singleton>().build();
+
+    auto timings = _subject.warmup(4);
+
+    auto log = BuildLog::entries();
+    ASSERT_EQ(2u, timings.size());
+    ASSERT_LT(BuildLog::positionOf("Service1"), BuildLog::positionOf("Top"));
+    ASSERT_EQ(1, std::count(log.begin(), log.end(), "Service1"));
+}
+
+TEST_F(WarmupTests, Warmup_GivenSingletonDependencyFromCustomResolver_BuildsItOnDemand)
+{
+    _subject.bind<Middle, std::shared_ptr<Service<1>>>()
+        .withIndexedParameterFrom<0, std::shared_ptr<Service<1>>>([] (const cdif::Container& ctx)
+            {
+                return ctx.resolve<std::shared_ptr<Service<1>>>();
+            })
+        .in<cdif::Scope::Singleton>()
+        .build();
+    _subject.bind<Service<1>>().in<cdif::Scope::Singleton>().build();
+
+    auto timings = _subject.warmup(4);
+
+    auto log = BuildLog::entries();
+    ASSERT_EQ(2u, timings.size());
+    ASSERT_LT(BuildLog::positionOf("Service1"), BuildLog::positionOf("Middle"));
+    ASSERT_EQ(1, std::count(log.begin(), log.end(), "Service1"));
+}
+
+TEST_F(WarmupTests, Warmup_GivenManyIndependentSingletons_BuildsEachOnce)
+{
+    _subject.bind<Service<0>>().in<cdif::Scope::Singleton>().build();
+    _subject.bind<Service<1>>().in<cdif::Scope::Singleton>().build();
+    _subject.bind<Service<2>>().in<cdif::Scope::Singleton>().build();
+    _subject.bind<Service<3>>().in<cdif::Scope::Singleton>().build();
+
+    auto timings = _subject.warmup(4);
+
+    auto log = BuildLog::entries();
+    std::sort(log.begin(), log.end());
+    ASSERT_EQ(4u, timings.size());
+    ASSERT_EQ(std::vector<std::string>({ "Service0", "Service1", "Service2", "Service3" }), log);
+}
+
+TEST_F(WarmupTests, Warmup_GivenThrowingSingleton_RethrowsAndSkipsDependents)
+{
+    _subject.bind<Failing>().in<cdif::Scope::Singleton>().build();
+    _subject.bind<DependsOnFailing, Failing&>().in<cdif::Scope::Singleton>().build();
+
+    ASSERT_THROW(_subject.warmup(2), std::runtime_error);
+    ASSERT_TRUE(BuildLog::entries().empty());
+}
+
+TEST_F(WarmupTests, Warmup_GivenCircularSingletons_ThrowsBeforeBuilding)
+{
+    _subject.bind<CycleA, CycleB&>().in<cdif::Scope::Singleton>().build();
+    _subject.bind<CycleB, CycleA&>().in<cdif::Scope::Singleton>().build();
+    _subject.bind<Service<0>>().in<cdif::Scope::Singleton>().build();
+
+    ASSERT_THROW(_subject.warmup(2), std::runtime_error);
+    ASSERT_TRUE(BuildLog::entries().empty());
+}
+
+TEST_F(WarmupTests, ResolveAsync_GivenService_BuildsOnlySingletonsBeneathIt)
+{
+    _subject.bind<Top, Middle>().build();
+    _subject.bind<Middle, std::shared_ptr<Service<1>>>().build();
+    _subject.bind<Service<1>>().in<cdif::Scope::Singleton>().build();
+    _subject.bind<Service<2>>().in<cdif::Scope::Singleton>().build();
+
+    auto result = _subject.resolveAsync<Top>().get();
+
+    auto log = BuildLog::entries();
+    ASSERT_EQ(_subject.resolve<std::shared_ptr<Service<1>>>(), result.m_middle.m_service);
+    ASSERT_EQ(std::vector<std::string>({ "Service1", "Middle", "Top" }), log);
+}
+
+TEST_F(WarmupTests, ResolveAsync_GivenIndependentSingletons_BuildsThemConcurrently)
+{
+    s_started.store(0);
+    _subject.bind<Rendezvous<0>>().in<cdif::Scope::Singleton>().build();
+    _subject.bind<Rendezvous<1>>().in<cdif::Scope::Singleton>().build();
+    _subject.bind<FanOut, Rendezvous<0>&, Rendezvous<1>&>().build();
+    auto pool = cdif::WorkStealingThreadPool(2);
+
+    auto result = _subject.resolveAsync<FanOut>([&pool] (std::function<void ()> task) { pool.submit(std::move(task)); });
+
+    ASSERT_TRUE(result.get().m_concurrent);
+}
+
+TEST_F(WarmupTests, ResolveAsync_GivenThrowingSingleton_ThrowsFromFuture)
+{
+    _subject.bind<Failing>().in<cdif::Scope::Singleton>().build();
+    _subject.bind<DependsOnFailing, Failing&>().build();
+
+    auto result = _subject.resolveAsync<DependsOnFailing>();
+
+    ASSERT_THROW(result.get(), std::runtime_error);
+    ASSERT_TRUE(BuildLog::entries().empty());
+}
+
+TEST_F(WarmupTests, ResolveAsync_GivenCircularSingletons_ThrowsFromFuture)
+{
+    _subject.bind<CycleA, CycleB&>().in<cdif::Scope::Singleton>().build();
+    _subject.bind<CycleB, CycleA&>().in<cdif::Scope::Singleton>().build();
+
+    auto result = _subject.resolveAsync<CycleA&>();
+
+    ASSERT_THROW(result.get(), std::runtime_error);
+    ASSERT_TRUE(BuildLog::entries().empty());
+}
+
+TEST_F(WarmupTests, ResolveAsync_GivenUnregisteredService_ThrowsFromFuture)
+{
+    auto result = _subject.resolveAsync<Service<0>>();
+
+    ASSERT_THROW(result.get(), std::invalid_argument);
+}
@@ -0,0 +1,228 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace cdif {
+    // Runs the task it is given, now or later and on any thread.
+    typedef std::function<void (std::function<void ()>)> Executor;
+
+    // Each worker owns a queue it pushes to and pops from at the back, idle
+    // workers steal from the front of the other queues. Tasks submitted from
+    // outside the pool are spread across the queues round robin.
+    class WorkStealingThreadPool
+    {
+        private:
+            struct WorkQueue
+            {
+                std::mutex mutex;
+                std::deque<std::function<void ()>> tasks;
+            };
+
+            std::vector<std::unique_ptr<WorkQueue>> m_queues;
+            std::vector<std::thread> m_workers;
+            std::mutex m_mutex;
+            std::condition_variable m_wake;
+            std::condition_variable m_idle;
+            size_t m_queued;
+            size_t m_pending;
+            bool m_stopping;
+            std::atomic<size_t> m_nextQueue;
+
+            struct CurrentWorker
+            {
+                const WorkStealingThreadPool* pool;
+                size_t index;
+            };
+
+            static CurrentWorker& currentWorker()
+            {
+                thread_local CurrentWorker worker { nullptr, 0 };
+                return worker;
+            }
+
+            bool tryTake(size_t index, std::function<void ()>& task)
+            {
+                {
+                    auto& own = *m_queues[index];
+                    std::lock_guard<std::mutex> lock(own.mutex);
+                    if (!own.tasks.empty()) {
+                        task = std::move(own.tasks.back());
+                        own.tasks.pop_back();
+                        return true;
+                    }
+                }
+
+                for (size_t offset = 1; offset < m_queues.size(); offset++) {
+                    auto& victim = *m_queues[(index + offset) % m_queues.size()];
+                    std::lock_guard<std::mutex> lock(victim.mutex);
+                    if (!victim.tasks.empty()) {
+                        task = std::move(victim.tasks.front());
+                        victim.tasks.pop_front();
+                        return true;
+                    }
+                }
+
+                return false;
+            }
+
+            void run(size_t index)
+            {
+                currentWorker() = CurrentWorker { this, index };
+
+                while (true) {
+                    {
+                        std::unique_lock<std::mutex> lock(m_mutex);
+                        m_wake.wait(lock, [this] () { return m_stopping || m_queued > 0; });
+                        if (m_queued == 0)
+                            return;
+                    }
+
+                    auto task = std::function<void ()>();
+                    if (!tryTake(index, task))
+                        continue;
+
+                    {
+                        std::lock_guard<std::mutex> lock(m_mutex);
+                        m_queued--;
+                    }
+
+                    task();
+
+                    std::lock_guard<std::mutex> lock(m_mutex);
+                    if (--m_pending == 0)
+                        m_idle.notify_all();
+                }
+            }
+
+        public:
+            explicit WorkStealingThreadPool(size_t threads)
+                : m_queues(),
+                m_workers(),
+                m_mutex(),
+                m_wake(),
+                m_idle(),
+                m_queued(0),
+                m_pending(0),
+                m_stopping(false),
+                m_nextQueue(0)
+            {
+                if (threads == 0)
+                    threads = 1;
+
+                for (size_t i = 0; i < threads; i++)
+                    m_queues.push_back(std::make_unique<WorkQueue>());
+                for (size_t i = 0; i < threads; i++)
+                    m_workers.emplace_back([this, i] () { run(i); });
+            }
+
+            ~WorkStealingThreadPool()
+            {
+                {
+                    std::lock_guard<std::mutex> lock(m_mutex);
+                    m_stopping = true;
+                }
+                m_wake.notify_all();
+
+                for (auto& worker : m_workers)
+                    worker.join();
+            }
+
+            WorkStealingThreadPool(const WorkStealingThreadPool&) = delete;
+            WorkStealingThreadPool& operator=(const WorkStealingThreadPool&) = delete;
+
+            // Tasks must not throw, wrap them if they can.
+            void submit(std::function<void ()> task)
+            {
+                auto& worker = currentWorker();
+                auto index = (worker.pool == this)
+                    ? worker.index
+                    : m_nextQueue.fetch_add(1, std::memory_order_relaxed) % m_queues.size();
+
+                {
+                    auto& queue = *m_queues[index];
+                    std::lock_guard<std::mutex> lock(queue.mutex);
+                    queue.tasks.push_back(std::move(task));
+                }
+
+                {
+                    std::lock_guard<std::mutex> lock(m_mutex);
+                    m_queued++;
+                    m_pending++;
+                }
+                m_wake.notify_one();
+            }
+
+            // Blocks until every submitted task, including tasks submitted by
+            // other tasks, has finished.
+            void wait()
+            {
+                std::unique_lock<std::mutex> lock(m_mutex);
+                m_idle.wait(lock, [this] () { return m_pending == 0; });
+            }
+
+            size_t size() const
+            {
+                return m_workers.size();
+            }
+
+            // Shared by every container, for work that does not bring its
+            // own executor.
+            static WorkStealingThreadPool& shared()
+            {
+                static auto pool = WorkStealingThreadPool(std::max(std::thread::hardware_concurrency(), 2u));
+                return pool;
+            }
+
+            // Calls body(i) for every i below count and returns once all of
+            // them have finished. The calling thread takes indices too and
+            // only ever waits on calls already running on a worker, so the
+            // caller may itself be one of the pool's tasks. body must not
+            // throw.
+            template <typename TBody>
+            void parallelFor(size_t count, const TBody& body)
+            {
+                struct Loop
+                {
+                    std::atomic<size_t> next;
+                    std::atomic<size_t> finished;
+                    const TBody* body;
+                    size_t count;
+                    std::mutex mutex;
+                    std::condition_variable done;
+
+                    void run()
+                    {
+                        for (auto i = next.fetch_add(1); i < count; i = next.fetch_add(1)) {
+                            (*body)(i);
+                            if (finished.fetch_add(1) + 1 == count) {
+                                std::lock_guard<std::mutex> lock(mutex);
+                                done.notify_all();
+                            }
+                        }
+                    }
+                };
+
+                auto loop = std::make_shared<Loop>();
+                loop->next.store(0);
+                loop->finished.store(0);
+                loop->body = &body;
+                loop->count = count;
+
+                for (size_t i = 1; i < std::min(count, size() + 1); i++)
+                    submit([loop] () { loop->run(); });
+                loop->run();
+
+                std::unique_lock<std::mutex> lock(loop->mutex);
+                loop->done.wait(lock, [&loop] () { return loop->finished.load() == loop->count; });
+            }
+    };
+}
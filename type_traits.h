@@ -2,14 +2,55 @@
 
 #include <any>
 #include <array>
+#include <cstddef>
 #include <functional>
+#include <list>
 #include <memory>
+#include <memory_resource>
 #include <optional>
 #include <type_traits>
 #include <utility>
+#include <vector>
 
 namespace cdif
 {
+    typedef const void* TypeKey;
+
+    template <typename T>
+    struct type_key_tag
+    {
+        static constexpr char value = 0;
+    };
+
+    template <typename T>
+    inline constexpr TypeKey type_key = &type_key_tag<T>::value;
+
+    template <typename T>
+    class Lazy;
+
+    template <typename T>
+    class LazyList;
+
+    template <typename T>
+    inline constexpr bool is_lazy = false;
+
+    template <typename T>
+    inline constexpr bool is_lazy<Lazy<T>> = true;
+
+    template <typename T>
+    class Provider;
+
+    template <typename T>
+    inline constexpr bool is_provider = false;
+
+    template <typename T>
+    inline constexpr bool is_provider<Provider<T>> = true;
+
+    // Handles the container builds itself rather than resolving from a
+    // registration.
+    template <typename T>
+    inline constexpr bool is_service_handle = is_lazy<T> || is_provider<T>;
+
     template <typename T>
     struct remove_cvref
     {
@@ -70,8 +111,8 @@ namespace cdif
         using type = T;
     };
 
-    template <typename T>
-    struct remove_smart_ptr<std::unique_ptr<T>>
+    template <typename T, typename TDeleter>
+    struct remove_smart_ptr<std::unique_ptr<T, TDeleter>>
     {
         using type = T;
     };
@@ -85,6 +126,62 @@ namespace cdif
         using type = remove_smart_ptr_t<remove_cvref_pointer_t<T>>;
     };
 
+    // The type a bind() keeps its registration under, the other forms of the
+    // service (pointers, smart pointers, factories) are derived from it, e.g.
+    // Foo for Foo*, std::shared_ptr<Foo> and std::function<Foo (int)>.
+    template <typename T>
+    struct canonical_service
+    {
+        using type = typename get_base_type<T>::type;
+    };
+
+    template <typename TReturn, typename ... TArgs>
+    struct canonical_service<std::function<TReturn (TArgs...)>>
+    {
+        using type = typename get_base_type<TReturn>::type;
+    };
+
+    // A bindList() keeps its PerDependency registration under the vector,
+    // the other list types are derived from it.
+    template <typename T>
+    struct canonical_service<std::list<T>>
+    {
+        using type = std::vector<T>;
+    };
+
+    template <typename T, size_t N>
+    struct canonical_service<std::array<T, N>>
+    {
+        using type = std::vector<T>;
+    };
+
+    template <typename T>
+    struct canonical_service<std::pmr::vector<T>>
+    {
+        using type = std::vector<T>;
+    };
+
+    template <typename T>
+    struct canonical_service<LazyList<T>>
+    {
+        using type = std::vector<T>;
+    };
+
+    template <typename T>
+    using canonical_service_t = typename canonical_service<remove_cvref_t<T>>::type;
+
+    template <typename TList, typename = void>
+    inline constexpr bool has_reserve = false;
+
+    template <typename TList>
+    inline constexpr bool has_reserve<TList, std::void_t<decltype(std::declval<TList&>().reserve(size_t()))>> = true;
+
+    template <typename T>
+    struct type_identity
+    {
+        using type = T;
+    };
+
     template <typename T>
     inline constexpr bool is_singleton_type =
         std::is_pointer_v<remove_cvref_t<T>> ||
@@ -124,12 +221,4 @@ namespace cdif
 
         static constexpr bool value = { type::value };
     };
-
-    template <typename TDep, size_t Index, size_t FuncCount>
-    static const std::function<TDep (const Container&)> getResolverAtIndex(
-        const std::array<std::function<std::any ()>, FuncCount>& resolvers)
-    {
-        auto func = resolvers[Index]();
-        return std::any_cast<std::function<TDep (const Container&)>>(func);
-    }
 }
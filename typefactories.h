@@ -1,13 +1,59 @@
 #pragma once
 
 #include "cdif.h"
+#include "dependencychaintracker.h"
+#include "epoch.h"
+#include "threadpool.h"
 
+#include <array>
+#include <cstddef>
+#include <exception>
 #include <functional>
 #include <memory>
+#include <memory_resource>
+#include <new>
+#include <optional>
+#include <thread>
+#include <tuple>
 #include <utility>
 #include <type_traits>
 
 namespace cdif {
+    // Destroys an object allocated from a memory resource and returns its
+    // memory. The deleter remembers the allocation rather than the pointer
+    // it is given, so a pmr_unique_ptr<TService> converts to a
+    // pmr_unique_ptr<TInterface> like std::unique_ptr does.
+    class MemoryResourceDeleter
+    {
+        private:
+            std::pmr::memory_resource* m_resource;
+            void* m_allocation;
+            size_t m_size;
+            size_t m_alignment;
+
+        public:
+            MemoryResourceDeleter()
+                : m_resource(nullptr), m_allocation(nullptr), m_size(0), m_alignment(0) {}
+
+            MemoryResourceDeleter(std::pmr::memory_resource* resource, void* allocation, size_t size, size_t alignment)
+                : m_resource(resource), m_allocation(allocation), m_size(size), m_alignment(alignment) {}
+
+            template <typename T>
+            void operator()(T* instance) const
+            {
+                instance->~T();
+                m_resource->deallocate(m_allocation, m_size, m_alignment);
+            }
+
+            std::pmr::memory_resource* resource() const
+            {
+                return m_resource;
+            }
+    };
+
+    template <typename T>
+    using pmr_unique_ptr = std::unique_ptr<T, MemoryResourceDeleter>;
+
     template <typename TService, typename ... TArgs>
     static const std::function<TService (TArgs&&...)> defaultFactory()
     {
@@ -26,18 +72,36 @@ namespace cdif {
         return [] (TArgs&& ... args) { return static_cast<TInterface*>(new TService(std::forward<TArgs>(args)...)); };
     }
 
+    // Without a memory resource shared pointers come from std::make_shared,
+    // with one the object and its control block come from the resource.
     template <typename TService, typename ... TArgs>
-    static const std::function<std::shared_ptr<TService> (TArgs&&...)> defaultSharedPtrFactory()
+    static const std::function<std::shared_ptr<TService> (TArgs&&...)> defaultSharedPtrFactory(
+        std::pmr::memory_resource* resource = nullptr)
     {
-        return [] (TArgs&& ... args) { return std::make_shared<TService>(std::forward<TArgs>(args)...); };
+        if (resource == nullptr)
+            return [] (TArgs&& ... args) { return std::make_shared<TService>(std::forward<TArgs>(args)...); };
+
+        return [resource] (TArgs&& ... args)
+            {
+                return std::allocate_shared<TService>(
+                    std::pmr::polymorphic_allocator<TService>(resource), std::forward<TArgs>(args)...);
+            };
     }
 
     template <typename TService, typename TInterface, typename ... TArgs>
-    static const std::function<std::shared_ptr<TInterface> (TArgs&&...)> defaultInterfaceSharedPtrFactory()
+    static const std::function<std::shared_ptr<TInterface> (TArgs&&...)> defaultInterfaceSharedPtrFactory(
+        std::pmr::memory_resource* resource = nullptr)
     {
-        return [] (TArgs&& ... args)
+        if (resource == nullptr)
+            return [] (TArgs&& ... args)
+                {
+                    return static_cast<std::shared_ptr<TInterface>>(std::make_shared<TService>(std::forward<TArgs>(args)...));
+                };
+
+        return [resource] (TArgs&& ... args)
             {
-                return static_cast<std::shared_ptr<TInterface>>(std::make_shared<TService>(std::forward<TArgs>(args)...));
+                return static_cast<std::shared_ptr<TInterface>>(std::allocate_shared<TService>(
+                    std::pmr::polymorphic_allocator<TService>(resource), std::forward<TArgs>(args)...));
             };
     }
 
@@ -56,29 +120,166 @@ namespace cdif {
             };
     }
 
-    template <typename TList, typename TBase, typename ... Ts, size_t ... Indices, size_t TListSize = sizeof...(Ts)>
+    // A null resource means std::pmr::get_default_resource() at the time of
+    // each resolve.
+    template <typename TService, typename ... TArgs>
+    static const std::function<pmr_unique_ptr<TService> (TArgs&&...)> defaultPmrUniquePtrFactory(
+        std::pmr::memory_resource* resource = nullptr)
+    {
+        return [resource] (TArgs&& ... args)
+            {
+                auto* memoryResource = (resource == nullptr) ? std::pmr::get_default_resource() : resource;
+                auto* allocation = memoryResource->allocate(sizeof(TService), alignof(TService));
+                try {
+                    auto* instance = new (allocation) TService(std::forward<TArgs>(args)...);
+                    return pmr_unique_ptr<TService>(instance,
+                        MemoryResourceDeleter(memoryResource, allocation, sizeof(TService), alignof(TService)));
+                } catch (...) {
+                    memoryResource->deallocate(allocation, sizeof(TService), alignof(TService));
+                    throw;
+                }
+            };
+    }
+
+    template <typename TService, typename TInterface, typename ... TArgs>
+    static const std::function<pmr_unique_ptr<TInterface> (TArgs&&...)> defaultInterfacePmrUniquePtrFactory(
+        std::pmr::memory_resource* resource = nullptr)
+    {
+        auto factory = defaultPmrUniquePtrFactory<TService, TArgs...>(resource);
+        return [factory] (TArgs&& ... args)
+            {
+                return static_cast<pmr_unique_ptr<TInterface>>(factory(std::forward<TArgs>(args)...));
+            };
+    }
+
+    template <typename TList, typename TBase, typename ... Ts, size_t ... Indices>
     static const TList buildInitializerListFrom(
-        const std::array<std::function<std::any ()>, sizeof...(Ts)>& resolvers,
+        const std::tuple<DependencyResolver<Ts>...>& resolvers,
+        const Container& ctx,
+        std::index_sequence<Indices...>)
+    {
+        return { static_cast<TBase>(std::get<Indices>(resolvers)(ctx))... };
+    }
+
+    // Each element is constructed in place from what its resolver returns.
+    template <typename TList, typename ... Ts, size_t ... Indices>
+    static void appendListFrom(
+        TList& list,
+        const std::tuple<DependencyResolver<Ts>...>& resolvers,
         const Container& ctx,
         std::index_sequence<Indices...>)
     {
-        return { static_cast<TBase>(getResolverAtIndex<Ts, Indices, TListSize>(resolvers)(ctx))... };
+        if constexpr (has_reserve<TList>)
+            list.reserve(list.size() + sizeof...(Ts));
+        ( list.emplace_back(std::get<Indices>(resolvers)(ctx)), ... );
+    }
+
+    namespace detail {
+        struct PerThreadInstanceRequested {};
+
+        // Marks a pool worker building a parallel list element for another
+        // thread. PerThread instances belong to the resolving thread, so
+        // reaching one throws PerThreadInstanceRequested and the element is
+        // built again on the resolving thread.
+        class ResolvingForOtherThread
+        {
+            private:
+                bool m_previous;
+
+                static bool& active()
+                {
+                    thread_local bool value = false;
+                    return value;
+                }
+
+            public:
+                ResolvingForOtherThread() : m_previous(std::exchange(active(), true)) {}
+
+                ~ResolvingForOtherThread()
+                {
+                    active() = m_previous;
+                }
+
+                ResolvingForOtherThread(const ResolvingForOtherThread&) = delete;
+                ResolvingForOtherThread& operator=(const ResolvingForOtherThread&) = delete;
+
+                static bool isActive()
+                {
+                    return active();
+                }
+        };
     }
 
-    template <typename TList, typename TBase, typename ... Ts, size_t ... Indices, size_t TListSize = sizeof...(Ts)>
-    static constexpr TList buildListFrom(
-        const std::array<std::function<std::any ()>, sizeof...(Ts)>& resolvers,
+    // Resolves the elements on the shared pool, each one as its own task.
+    // They keep the resolving thread's dependency chain, so cycles are still
+    // detected, and are added to the list in order once all are built. An
+    // element reaching a PerThread registration on a worker is built again
+    // on the resolving thread afterwards, so it gets that thread's instance.
+    template <typename TList, typename TBase, typename ... Ts, size_t ... Indices>
+    static void appendListInParallelFrom(
+        TList& list,
+        const std::tuple<DependencyResolver<Ts>...>& resolvers,
         const Container& ctx,
         std::index_sequence<Indices...>)
     {
-        auto list = TList();
-        ( list.push_back(static_cast<TBase>(getResolverAtIndex<Ts, Indices, TListSize>(resolvers)(ctx))), ... );
-        return list;
+        auto elements = std::array<std::optional<TBase>, sizeof...(Ts)>();
+        auto errors = std::array<std::exception_ptr, sizeof...(Ts)>();
+        auto deferred = std::array<bool, sizeof...(Ts)>();
+        auto chain = PerThreadDependencyChainTracker::getThisChain();
+        auto resolvingThread = std::this_thread::get_id();
+
+        auto resolveAt = [&] (size_t index)
+        {
+            ( (index == Indices ? void(elements[Indices].emplace(std::get<Indices>(resolvers)(ctx))) : void()), ... );
+        };
+
+        auto resolveOnWorker = [&] (size_t index)
+        {
+            auto epoch = EpochGuard();
+            auto forOtherThread = detail::ResolvingForOtherThread();
+            auto& current = PerThreadDependencyChainTracker::getThisChain();
+            auto saved = std::exchange(current, chain);
+            try {
+                resolveAt(index);
+            } catch (...) {
+                current = std::move(saved);
+                throw;
+            }
+            current = std::move(saved);
+        };
+
+        WorkStealingThreadPool::shared().parallelFor(sizeof...(Ts), [&] (size_t index)
+            {
+                try {
+                    if (std::this_thread::get_id() == resolvingThread)
+                        resolveAt(index);
+                    else
+                        resolveOnWorker(index);
+                } catch (const detail::PerThreadInstanceRequested&) {
+                    deferred[index] = true;
+                } catch (...) {
+                    errors[index] = std::current_exception();
+                }
+            });
+
+        for (auto& error : errors)
+            if (error)
+                std::rethrow_exception(error);
+
+        // A list nested in another parallel list passes the request on.
+        for (size_t index = 0; index < deferred.size(); index++)
+            if (deferred[index])
+                resolveAt(index);
+
+        if constexpr (has_reserve<TList>)
+            list.reserve(list.size() + sizeof...(Ts));
+        for (auto& element : elements)
+            list.emplace_back(std::move(*element));
     }
 
     template <typename TList, typename TBase, typename ... Ts, typename Indices = std::make_index_sequence<sizeof...(Ts)>>
     static const std::function<TList (const Container&)> buildArrayFrom(
-        const std::array<std::function<std::any ()>, sizeof...(Ts)>& resolvers)
+        const std::tuple<DependencyResolver<Ts>...>& resolvers)
     {
         return [resolvers] (const Container& ctx) -> TList
         {
@@ -86,13 +287,32 @@ namespace cdif {
         };
     }
 
+    template <typename TList, typename TBase>
+    static TList emptyList(std::pmr::memory_resource* resource)
+    {
+        if constexpr (std::is_same_v<TList, std::pmr::vector<TBase>>)
+            return TList((resource == nullptr) ? std::pmr::get_default_resource() : resource);
+        else
+            return TList();
+    }
+
+    // A pmr list allocates from the resource, or from
+    // std::pmr::get_default_resource() at the time of each resolve when it
+    // is null. Other lists ignore it.
     template <typename TList, typename TBase, typename ... Ts, typename Indices = std::make_index_sequence<sizeof...(Ts)>>
     static const std::function<TList (const Container&)> buildListFrom(
-        const std::array<std::function<std::any ()>, sizeof...(Ts)>& resolvers)
+        const std::tuple<DependencyResolver<Ts>...>& resolvers,
+        bool parallel = false,
+        std::pmr::memory_resource* resource = nullptr)
     {
-        return [resolvers] (const Container& ctx) -> TList
+        return [resolvers, parallel, resource] (const Container& ctx) -> TList
         {
-            return buildListFrom<TList, TBase, Ts...>(resolvers, ctx, Indices{});
+            auto list = emptyList<TList, TBase>(resource);
+            if (parallel)
+                appendListInParallelFrom<TList, TBase, Ts...>(list, resolvers, ctx, Indices{});
+            else
+                appendListFrom<TList, Ts...>(list, resolvers, ctx, Indices{});
+            return list;
         };
     }
 }
@@ -0,0 +1,290 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#include "cdif.h"
+
+namespace cdif {
+    struct SingletonBuildTime
+    {
+        std::string typeName;
+        std::string name;
+        std::chrono::nanoseconds duration;
+    };
+
+    // Builds every singleton known to a registrar, or only those a given
+    // registration depends on. A singleton is only built once the singletons
+    // it depends on have been, either directly or through non-singleton
+    // registrations, so the time recorded for each one excludes the
+    // singletons beneath it. A dependency given through
+    // withIndexedParameterFrom() is an arbitrary function with no link in
+    // the graph: what it resolves is built on demand when the singleton
+    // using it is built, is not ordered before it, and counts towards its
+    // time.
+    class SingletonWarmup
+    {
+        public:
+            typedef std::function<void (std::exception_ptr, std::vector<SingletonBuildTime>)> Completion;
+
+        private:
+            // State of one run, shared by its tasks. The last task to finish
+            // calls done.
+            struct Run
+            {
+                const SingletonWarmup* warmup;
+                const Container* ctx;
+                Executor submit;
+                Completion done;
+                std::unique_ptr<std::atomic<size_t>[]> remaining;
+                std::unique_ptr<std::atomic<bool>[]> skipped;
+                std::vector<std::chrono::nanoseconds> durations;
+                std::atomic<size_t> unfinished;
+                std::mutex errorMutex;
+                std::exception_ptr error;
+            };
+
+            std::vector<std::shared_ptr<const SingletonInitializer>> m_initializers;
+            std::vector<std::vector<size_t>> m_dependents;
+            std::vector<size_t> m_dependencyCounts;
+
+            size_t indexOf(const std::shared_ptr<const SingletonInitializer>& initializer,
+                std::unordered_map<const SingletonInitializer*, size_t>& indices)
+            {
+                auto inserted = indices.emplace(initializer.get(), m_initializers.size());
+                if (inserted.second) {
+                    m_initializers.push_back(initializer);
+                    m_dependents.emplace_back();
+                    m_dependencyCounts.push_back(0);
+                }
+                return inserted.first->second;
+            }
+
+            // Missing dependencies are skipped here, building the singleton
+            // reports them with the usual resolve error.
+            static void collectDependencies(const RegistrationTable& registrations,
+                const Registration& registration,
+                std::unordered_set<const Registration*>& visited,
+                std::unordered_map<const SingletonInitializer*, const Registration*>& found)
+            {
+                for (auto& dependency : registration.dependencies()) {
+                    auto* target = registrations.find(dependency->query());
+                    if (target == nullptr || !visited.insert(target).second)
+                        continue;
+
+                    if (target->initializer() != nullptr)
+                        found.emplace(target->initializer().get(), target);
+                    else
+                        collectDependencies(registrations, *target, visited, found);
+                }
+            }
+
+            // Adds the singletons of the given registrations and, through
+            // their dependencies, every singleton beneath them.
+            void addSingletons(const RegistrationTable& registrations, const std::vector<const Registration*>& singletons)
+            {
+                auto indices = std::unordered_map<const SingletonInitializer*, size_t>();
+                auto pending = std::vector<const Registration*>();
+
+                for (auto* registration : singletons)
+                    if (indexOf(registration->initializer(), indices) == pending.size())
+                        pending.push_back(registration);
+
+                for (size_t i = 0; i < pending.size(); i++) {
+                    auto visited = std::unordered_set<const Registration*>();
+                    auto found = std::unordered_map<const SingletonInitializer*, const Registration*>();
+                    collectDependencies(registrations, *pending[i], visited, found);
+
+                    for (auto& dependency : found) {
+                        auto index = indexOf(dependency.second->initializer(), indices);
+                        if (index == pending.size())
+                            pending.push_back(dependency.second);
+
+                        m_dependents[index].push_back(i);
+                        m_dependencyCounts[i]++;
+                    }
+                }
+            }
+
+            void checkForCycles() const
+            {
+                auto counts = m_dependencyCounts;
+                auto ready = std::vector<size_t>();
+                for (size_t i = 0; i < counts.size(); i++)
+                    if (counts[i] == 0)
+                        ready.push_back(i);
+
+                size_t ordered = 0;
+                while (!ready.empty()) {
+                    auto index = ready.back();
+                    ready.pop_back();
+                    ordered++;
+
+                    for (auto dependent : m_dependents[index])
+                        if (--counts[dependent] == 0)
+                            ready.push_back(dependent);
+                }
+
+                if (ordered == counts.size())
+                    return;
+
+                auto cycle = std::string();
+                for (size_t i = 0; i < counts.size(); i++)
+                    if (counts[i] != 0)
+                        cycle += std::string(cycle.empty() ? "" : ", ") + m_initializers[i]->typeName;
+                throw std::runtime_error("Circular dependency detected between singletons: " + cycle);
+            }
+
+            // A singleton that fails, or depends on one that failed, is
+            // skipped and passes that on to its dependents.
+            static void build(const std::shared_ptr<Run>& run, size_t index)
+            {
+                auto& warmup = *run->warmup;
+                if (!run->skipped[index].load(std::memory_order_acquire)) {
+                    auto start = std::chrono::steady_clock::now();
+                    try {
+                        auto epoch = EpochGuard();
+                        warmup.m_initializers[index]->initialize(*run->ctx);
+                        run->durations[index] = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                            std::chrono::steady_clock::now() - start);
+                    } catch (...) {
+                        std::lock_guard<std::mutex> lock(run->errorMutex);
+                        if (!run->error)
+                            run->error = std::current_exception();
+                        run->skipped[index].store(true, std::memory_order_release);
+                    }
+                }
+
+                auto skipped = run->skipped[index].load(std::memory_order_acquire);
+                for (auto dependent : warmup.m_dependents[index]) {
+                    if (skipped)
+                        run->skipped[dependent].store(true, std::memory_order_release);
+                    if (run->remaining[dependent].fetch_sub(1, std::memory_order_acq_rel) == 1)
+                        run->submit([run, dependent] () { build(run, dependent); });
+                }
+
+                if (run->unfinished.fetch_sub(1, std::memory_order_acq_rel) == 1)
+                    run->done(run->error, warmup.timingsOf(run->durations));
+            }
+
+            // Slowest first.
+            std::vector<SingletonBuildTime> timingsOf(const std::vector<std::chrono::nanoseconds>& durations) const
+            {
+                auto timings = std::vector<SingletonBuildTime>();
+                timings.reserve(size());
+                for (size_t i = 0; i < size(); i++)
+                    timings.push_back(SingletonBuildTime { m_initializers[i]->typeName, m_initializers[i]->name, durations[i] });
+
+                std::sort(timings.begin(), timings.end(), [] (const auto& left, const auto& right)
+                    {
+                        return left.duration > right.duration;
+                    });
+                return timings;
+            }
+
+        public:
+            explicit SingletonWarmup(const RegistrationTable& registrations)
+                : m_initializers(), m_dependents(), m_dependencyCounts()
+            {
+                auto singletons = std::vector<const Registration*>();
+                registrations.forEach([&singletons] (const ServiceKey&, const Registration& registration)
+                    {
+                        if (registration.initializer() != nullptr)
+                            singletons.push_back(&registration);
+                    });
+
+                addSingletons(registrations, singletons);
+                checkForCycles();
+            }
+
+            // Only the singletons the root depends on, and the root itself
+            // when it is one.
+            SingletonWarmup(const RegistrationTable& registrations, const Registration& root)
+                : m_initializers(), m_dependents(), m_dependencyCounts()
+            {
+                auto singletons = std::vector<const Registration*>();
+                if (root.initializer() != nullptr) {
+                    singletons.push_back(&root);
+                } else {
+                    auto visited = std::unordered_set<const Registration*>();
+                    auto found = std::unordered_map<const SingletonInitializer*, const Registration*>();
+                    collectDependencies(registrations, root, visited, found);
+                    for (auto& dependency : found)
+                        singletons.push_back(dependency.second);
+                }
+
+                addSingletons(registrations, singletons);
+                checkForCycles();
+            }
+
+            size_t size() const
+            {
+                return m_initializers.size();
+            }
+
+            // Submits the singletons with no singleton dependencies to the
+            // executor, each finished singleton submits the dependents it
+            // unblocks. Nothing blocks waiting on another task, so any
+            // executor works. Once every task has finished, done receives the
+            // first exception thrown by a singleton's factory and the build
+            // times. This warmup must live until then.
+            void start(const Container& ctx, Executor submit, Completion done) const
+            {
+                auto run = std::make_shared<Run>();
+                run->warmup = this;
+                run->ctx = &ctx;
+                run->submit = std::move(submit);
+                run->done = std::move(done);
+                run->remaining = std::make_unique<std::atomic<size_t>[]>(size());
+                run->skipped = std::make_unique<std::atomic<bool>[]>(size());
+                run->durations.assign(size(), std::chrono::nanoseconds::zero());
+                run->unfinished.store(size(), std::memory_order_relaxed);
+                for (size_t i = 0; i < size(); i++) {
+                    run->remaining[i].store(m_dependencyCounts[i], std::memory_order_relaxed);
+                    run->skipped[i].store(false, std::memory_order_relaxed);
+                }
+
+                if (size() == 0) {
+                    run->done(nullptr, {});
+                    return;
+                }
+
+                for (size_t i = 0; i < size(); i++)
+                    if (m_dependencyCounts[i] == 0)
+                        run->submit([run, i] () { build(run, i); });
+            }
+
+            // Rethrows the first exception thrown by a singleton's factory
+            // once the pool has drained. Singletons depending on a failed
+            // singleton are not built.
+            std::vector<SingletonBuildTime> run(const Container& ctx, size_t threads) const
+            {
+                auto error = std::exception_ptr();
+                auto timings = std::vector<SingletonBuildTime>();
+                auto pool = WorkStealingThreadPool(std::min(threads, std::max<size_t>(size(), 1)));
+
+                start(ctx, [&pool] (std::function<void ()> task) { pool.submit(std::move(task)); },
+                    [&error, &timings] (std::exception_ptr failure, std::vector<SingletonBuildTime> built)
+                    {
+                        error = failure;
+                        timings = std::move(built);
+                    });
+                pool.wait();
+
+                if (error)
+                    std::rethrow_exception(error);
+                return timings;
+            }
+    };
+}